@@ -0,0 +1,349 @@
+#ifndef CR2_ARENA_LIST_HPP
+# define CR2_ARENA_LIST_HPP
+# pragma once
+
+#include <cstddef> // std::max_align_t
+#include <algorithm> // std::any_of, std::for_each
+#include <iterator> // std::forward_iterator_tag
+#include <memory> // std::construct_at
+#include <new> // std::align_val_t
+#include <type_traits> // std::remove_reference_t
+#include <utility> // std::exchange, std::pair
+
+#include "common.hpp"
+
+namespace cr2
+{
+
+template <std::size_t B>
+class arena_list;
+
+namespace detail
+{
+
+// one vtable per coroutine type, shared by all its entries
+struct arena_vtable
+{
+  std::size_t offset, size;
+
+  enum state (*state)(void const*) noexcept;
+  void (*invoke)(void*);
+  void (*reset)(void*);
+  void (*destroy)(void*) noexcept;
+};
+
+constexpr std::size_t align_up(std::size_t const s,
+  std::size_t const a) noexcept
+{
+  return (s + a - 1) / a * a;
+}
+
+class arena_entry
+{
+  template <std::size_t> friend class ::cr2::arena_list;
+
+private:
+  arena_vtable const* vt_;
+
+  void* get() noexcept { return reinterpret_cast<char*>(this) + vt_->offset; }
+  void const* get() const noexcept
+  {
+    return reinterpret_cast<char const*>(this) + vt_->offset;
+  }
+
+public:
+  explicit arena_entry(arena_vtable const* const vt) noexcept: vt_(vt) { }
+
+  arena_entry(arena_entry const&) = delete;
+  arena_entry& operator=(arena_entry const&) = delete;
+
+  //
+  void const* id() const noexcept { return get(); }
+  enum state state() const noexcept { return vt_->state(get()); }
+
+  //
+  void reset() const { vt_->reset(const_cast<arena_entry*>(this)->get()); }
+};
+
+template <typename C>
+inline constexpr arena_vtable arena_vtable_v{
+  align_up(sizeof(arena_entry), alignof(C)),
+  align_up(align_up(sizeof(arena_entry), alignof(C)) + sizeof(C),
+    alignof(std::max_align_t)),
+  [](void const* const p) noexcept
+  {
+    return static_cast<C const*>(p)->state();
+  },
+  [](void* const p) { (*static_cast<C*>(p))(); },
+  [](void* const p) { static_cast<C*>(p)->reset(); },
+  [](void* const p) noexcept { static_cast<C*>(p)->~C(); }
+};
+
+}
+
+// coroutines are stored back to back in blocks of (at least) B bytes, every
+// entry carries a single pointer to the vtable of its type
+template <std::size_t B = 64 * 1024>
+class arena_list
+{
+  static_assert(!(B % alignof(std::max_align_t)));
+
+private:
+  struct alignas(std::max_align_t) block
+  {
+    block* next_;
+    char* end_;
+    std::size_t capacity_;
+
+    char* begin() noexcept { return reinterpret_cast<char*>(this + 1); }
+  };
+
+  block* head_{}, *tail_{};
+
+  std::size_t size_{};
+
+  template <typename E>
+  class iterator_base
+  {
+    friend class arena_list;
+
+  private:
+    block* b_{};
+    char* p_{};
+
+    iterator_base(block* const b, char* const p) noexcept: b_(b), p_(p)
+    {
+      skip();
+    }
+
+    void skip() noexcept
+    { // step over exhausted or unused blocks
+      for (; b_ && (p_ == b_->end_); b_ = b_->next_, p_ = b_ ? b_->begin() :
+        nullptr);
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = detail::arena_entry;
+    using pointer = E*;
+    using reference = E&;
+
+    iterator_base() = default;
+
+    //
+    bool operator==(iterator_base const& o) const noexcept
+    {
+      return p_ == o.p_;
+    }
+
+    reference operator*() const noexcept
+    {
+      return *reinterpret_cast<E*>(p_);
+    }
+
+    pointer operator->() const noexcept { return &**this; }
+
+    iterator_base& operator++() noexcept
+    {
+      p_ += reinterpret_cast<detail::arena_entry*>(p_)->vt_->size;
+      skip();
+
+      return *this;
+    }
+
+    iterator_base operator++(int) noexcept
+    {
+      auto const r(*this); ++*this; return r;
+    }
+  };
+
+  //
+  void* allocate(std::size_t const sz)
+  {
+    for (; tail_; tail_ = tail_->next_)
+    {
+      if (std::size_t(tail_->begin() + tail_->capacity_ - tail_->end_) >= sz)
+      {
+        return std::exchange(tail_->end_, tail_->end_ + sz);
+      }
+      else if (!tail_->next_)
+      {
+        break;
+      }
+    }
+
+    // a single allocation per block, not per coroutine
+    auto const c(std::max(B, sz));
+    auto const b(static_cast<block*>(::operator new(sizeof(block) + c,
+      std::align_val_t(alignof(block)))));
+
+    b->next_ = {};
+    b->end_ = b->begin() + sz;
+    b->capacity_ = c;
+
+    (tail_ ? tail_->next_ : head_) = b;
+    tail_ = b;
+
+    return b->begin();
+  }
+
+public:
+  using iterator = iterator_base<detail::arena_entry>;
+  using const_iterator = iterator_base<detail::arena_entry const>;
+
+  explicit arena_list(auto&& ...c)
+  {
+    (
+      emplace_back(std::forward<decltype(c)>(c)),
+      ...
+    );
+  }
+
+  ~arena_list()
+  {
+    clear();
+
+    for (auto b(head_); b;)
+    {
+      ::operator delete(std::exchange(b, b->next_),
+        std::align_val_t(alignof(block)));
+    }
+  }
+
+  arena_list(arena_list const&) = delete;
+  arena_list& operator=(arena_list const&) = delete;
+
+  //
+  explicit operator bool() const noexcept
+  {
+    return std::any_of(
+      begin(),
+      end(),
+      [](auto&& e) noexcept { return e.state(); }
+    );
+  }
+
+  auto operator()() const
+  {
+    bool p{}, s{};
+
+    std::for_each(
+      begin(),
+      end(),
+      [&](auto&& e)
+      {
+        if (e.state() >= NEW)
+        {
+          e.vt_->invoke(const_cast<detail::arena_entry&>(e).get());
+
+          auto const state(e.state());
+
+          p = p || (PAUSED == state);
+          s = s || (SUSPENDED == state);
+        }
+      }
+    );
+
+    return std::pair(p, s);
+  }
+
+  //
+  iterator begin() noexcept
+  {
+    return {head_, head_ ? head_->begin() : nullptr};
+  }
+
+  iterator end() noexcept { return {}; }
+
+  const_iterator begin() const noexcept
+  {
+    return {head_, head_ ? head_->begin() : nullptr};
+  }
+
+  const_iterator end() const noexcept { return {}; }
+
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+  //
+  bool empty() const noexcept { return !size_; }
+  auto size() const noexcept { return size_; }
+
+  //
+  void assign(auto&& ...c)
+  {
+    clear();
+
+    (
+      emplace_back(std::forward<decltype(c)>(c)),
+      ...
+    );
+  }
+
+  // destroys the coroutines, but keeps the blocks for reuse
+  void clear() noexcept
+  {
+    for (auto b(head_); b; b = b->next_)
+    {
+      for (auto p(b->begin()); p != b->end_;)
+      {
+        auto& e(*reinterpret_cast<detail::arena_entry*>(p));
+        auto const vt(e.vt_);
+
+        vt->destroy(e.get());
+        std::destroy_at(&e);
+
+        p += vt->size;
+      }
+
+      b->end_ = b->begin();
+    }
+
+    tail_ = head_;
+    size_ = {};
+  }
+
+  auto& emplace_back(auto&& c)
+  {
+    using C = std::remove_reference_t<decltype(c)>;
+    static_assert(alignof(C) <= alignof(std::max_align_t));
+
+    constexpr auto& vt(detail::arena_vtable_v<C>);
+
+    auto const p(static_cast<char*>(allocate(vt.size)));
+    auto const e(std::construct_at(
+      reinterpret_cast<detail::arena_entry*>(p), &vt));
+
+    try
+    {
+      ::new (p + vt.offset) C(std::move(c));
+    }
+    catch (...)
+    {
+      tail_->end_ = p;
+
+      throw;
+    }
+
+    ++size_;
+
+    return *e;
+  }
+
+  auto& push_back(auto&& c) { return emplace_back(std::move(c)); }
+
+  //
+  void reset() const
+  {
+    std::for_each(
+      begin(),
+      end(),
+      [](auto& e) { e.reset(); }
+    );
+  }
+};
+
+}
+
+#endif // CR2_ARENA_LIST_HPP
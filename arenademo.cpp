@@ -0,0 +1,69 @@
+#include <iostream>
+
+//#include "basic_coroutine.hpp"
+#include "portable_coroutine.hpp"
+#include "libnone_support.hpp"
+
+#include "arena_list.hpp"
+
+using namespace cr2::literals;
+
+int main()
+{
+  cr2::arena_list l{
+    cr2::make_plain<128_k>(
+      [](auto& c)
+      {
+        for (;;)
+        {
+          std::cout << 'a' << std::endl;
+          c.suspend();
+        }
+      }
+    ),
+    cr2::make_plain<128_k>(
+      [](auto& c)
+      {
+        for (;;)
+        {
+          std::cout << 'b' << std::endl;
+          c.suspend();
+        }
+      }
+    ),
+  };
+
+  l.push_back(
+    cr2::make_plain<128_k>(
+      [](auto& c)
+      {
+        std::intmax_t j(6);
+
+        for (auto i(j - 1); 1 != i; --i)
+        {
+          std::cout << "coro\n";
+
+          j *= i;
+          c.suspend();
+        }
+
+        std::cout << j << std::endl;
+      }
+    )
+  );
+
+  while (
+    std::all_of(
+      l.cbegin(),
+      l.cend(),
+      [](auto&& e) noexcept { return e.state(); }
+    )
+  )
+  {
+    l();
+  }
+
+  std::cout << l.size() << " coroutines" << std::endl;
+
+  return 0;
+}
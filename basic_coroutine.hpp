@@ -2,20 +2,36 @@
 # define CR2_BASIC_COROUTINE_HPP
 # pragma once
 
-#include "generic/savestate.hpp"
+#if defined(CR2_ASM_SWITCH)
+# include "context_switch.hpp"
+#else
+# include "generic/savestate.hpp"
+#endif
+
+#include <cstring> // std::memcpy
 
 #include "common.hpp"
+#include "ready_queue.hpp"
+#include "stack.hpp"
 
 namespace cr2
 {
 
-template <typename F, typename R, std::size_t S>
-class coroutine
+template <typename F, typename R, std::size_t S,
+  template <std::size_t> class A = inline_stack>
+class coroutine: detail::ready_node
 {
-private:
-  enum : std::size_t { N = S / sizeof(void*) };
+  template <typename, typename, std::size_t, template <std::size_t> class>
+  friend class coroutine;
+
+  friend class detail::ready_queue;
 
+private:
+#if defined(CR2_ASM_SWITCH)
+  void* in_, *out_;
+#else
   gnr::statebuf in_, out_;
+#endif
 
   enum state state_;
 
@@ -35,7 +51,7 @@ private:
     >
   > r_;
 
-  alignas(std::max_align_t) void* stack_[N];
+  A<S> stack_;
 
   //
   void destroy()
@@ -73,12 +89,97 @@ private:
     }
   }
 
+#if defined(CR2_ASM_SWITCH)
+  static void entry(void* const p) noexcept
+  {
+    auto& c(*static_cast<coroutine*>(p));
+
+    c.execute();
+
+    c.state_ = DEAD;
+
+    void* dummy;
+    detail::switch_context(dummy, c.out_); // return outside
+  }
+
+  void start() noexcept
+  { // NEW, DEAD
+    reset();
+
+    in_ = detail::make_context(stack_.top(), this, entry);
+  }
+
+  template <enum state State>
+  void suspend() noexcept
+  {
+    if constexpr(SUSPENDED == State) enqueue(); else park();
+
+    state_ = State;
+    detail::switch_context(in_, out_);
+  }
+#else
+  // Save == false reuses the out_ of the coroutine, that transfers to us
+  template <bool Save>
+  __attribute__((always_inline)) void enter() noexcept
+  {
+    if (Save && savestate(out_))
+    {
+      clobber_all();
+    }
+    else if (SUSPENDED == state())
+    {
+      state_ = RUNNING;
+
+      restorestate(in_); // return inside
+    }
+    else // NEW, DEAD
+    {
+      reset();
+
+      state_ = RUNNING;
+
+#if defined(__GNUC__)
+# if defined(i386) || defined(__i386) || defined(__i386__)
+      asm volatile(
+        "movl %0, %%esp"
+        :
+        : "r" (stack_.top())
+      );
+# elif defined(__amd64__) || defined(__amd64) || defined(__x86_64__) ||\
+  defined(__x86_64)
+      asm volatile(
+        "movq %0, %%rsp"
+        :
+        : "r" (stack_.top())
+      );
+# elif defined(__aarch64__) || defined(__arm__)
+      asm volatile(
+        "mov sp, %0"
+        :
+        : "r" (stack_.top())
+      );
+# else
+#   error "can't switch stack frame"
+# endif
+#else
+# error "can't switch stack frame"
+#endif
+
+      execute();
+
+      state_ = DEAD;
+      restorestate(out_); // return outside
+    }
+  }
+
   template <enum state State>
 #ifdef __clang__
   __attribute__((noinline))
 #endif
   void suspend() noexcept
   {
+    if constexpr(SUSPENDED == State) enqueue(); else park();
+
     if (state_ = State; savestate(in_))
     {
       clobber_all();
@@ -88,10 +189,14 @@ private:
       restorestate(out_);
     }
   }
+#endif
 
 public:
   explicit coroutine(F&& f)
-    noexcept(noexcept(F(std::move(f)))):
+    noexcept(
+      noexcept(F(std::move(f))) &&
+      std::is_nothrow_default_constructible_v<A<S>>
+    ):
     state_{NEW},
     f_(std::move(f))
   {
@@ -118,7 +223,11 @@ public:
   coroutine(coroutine const&) = delete;
 
   coroutine(coroutine&& o)
-    noexcept(noexcept(F(std::move(o.f_))) && noexcept(o.destroy())):
+    noexcept(
+      noexcept(F(std::move(o.f_))) &&
+      noexcept(o.destroy()) &&
+      std::is_nothrow_default_constructible_v<A<S>>
+    ):
     state_{NEW},
     f_(std::move(o.f_))
   {
@@ -135,58 +244,19 @@ public:
   //
   explicit operator bool() const noexcept { return state_; }
 
-  __attribute__((noinline)) void operator()() noexcept
+#if defined(CR2_ASM_SWITCH)
+  void operator()() noexcept
   {
-    if (savestate(out_))
-    {
-      clobber_all();
-    }
-    else if (SUSPENDED == state())
-    {
-      state_ = RUNNING;
-
-      restorestate(in_); // return inside
-    }
-    else // NEW, DEAD
-    {
-      reset();
+    if (SUSPENDED != state()) start();
 
-      state_ = RUNNING;
+    state_ = RUNNING;
 
-#if defined(__GNUC__)
-# if defined(i386) || defined(__i386) || defined(__i386__)
-      asm volatile(
-        "movl %0, %%esp"
-        :
-        : "r" (&stack_[N])
-      );
-# elif defined(__amd64__) || defined(__amd64) || defined(__x86_64__) ||\
-  defined(__x86_64)
-      asm volatile(
-        "movq %0, %%rsp"
-        :
-        : "r" (&stack_[N])
-      );
-# elif defined(__aarch64__) || defined(__arm__)
-      asm volatile(
-        "mov sp, %0"
-        :
-        : "r" (&stack_[N])
-      );
-# else
-#   error "can't switch stack frame"
-# endif
+    detail::switch_context(out_, in_);
+  }
 #else
-# error "can't switch stack frame"
+  __attribute__((noinline)) void operator()() noexcept { enter<true>(); }
 #endif
 
-      execute();
-
-      state_ = DEAD;
-      restorestate(out_); // return outside
-    }
-  }
-
   //
   void const* id() const noexcept { return this; }
 
@@ -223,9 +293,18 @@ public:
 
   auto state() const noexcept { return state_; }
 
+#if defined(CR2_STACK_WATERMARK)
+  auto max_stack_used() const noexcept { return stack_.used(); }
+#endif
+
   //
   void pause() noexcept { suspend<PAUSED>(); }
-  void unpause() noexcept { state_ = SUSPENDED; }
+  void unpause() noexcept
+  {
+    if (PAUSED == state_) unpark();
+
+    state_ = SUSPENDED;
+  }
 
   void reset() noexcept(noexcept(destroy()))
   {
@@ -238,15 +317,42 @@ public:
       destroy();
     }
 
+    drop();
     state_ = NEW;
   }
 
   void suspend() noexcept { suspend<SUSPENDED>(); }
 
-  template <typename A, typename B, std::size_t C>
-  void suspend_to(coroutine<A, B, C>& c) noexcept
-  { // suspend means "out"
-    c(); suspend();
+  // symmetric transfer, c takes over our way out and we are suspended
+  template <typename G, typename Q, std::size_t T,
+    template <std::size_t> class B>
+#if !defined(CR2_ASM_SWITCH) && defined(__clang__)
+  __attribute__((noinline))
+#endif
+  void suspend_to(coroutine<G, Q, T, B>& c) noexcept
+  {
+    enqueue();
+    state_ = SUSPENDED;
+
+#if defined(CR2_ASM_SWITCH)
+    if (SUSPENDED != c.state()) c.start();
+
+    c.state_ = RUNNING;
+    c.out_ = out_;
+
+    detail::switch_context(in_, c.in_);
+#else
+    if (savestate(in_))
+    {
+      clobber_all();
+    }
+    else
+    {
+      std::memcpy(&c.out_, &out_, sizeof(out_));
+
+      c.template enter<false>();
+    }
+#endif
   }
 };
 
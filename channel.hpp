@@ -0,0 +1,224 @@
+#ifndef CR2_CHANNEL_HPP
+# define CR2_CHANNEL_HPP
+# pragma once
+
+#include <memory> // std::destroy_at
+#include <new> // std::launder
+#include <optional>
+#include <utility> // std::exchange
+
+#include "generic/forwarder.hpp"
+
+#include "common.hpp"
+
+namespace cr2
+{
+
+// bounded channel between coroutines of the same thread, the values live
+// in an inline ring buffer of N slots; send pauses while the channel is
+// full, recv pauses while it is empty, the peer is unpaused directly;
+// waiters are intrusive, live in the frames of the paused coroutines and
+// are woken in fifo order, so any number of senders and receivers may share
+// a channel
+template <typename T, std::size_t N>
+class channel
+{
+  static_assert(N);
+
+private:
+  class waiter
+  {
+    friend class channel;
+
+  private:
+    waiter** h_{}; // list head
+    waiter* prev_, *next_;
+
+    gnr::forwarder<void() noexcept> f_;
+
+    void link(waiter*& h) noexcept
+    { // append to the list, prev_ of the head points to the tail
+      h_ = &h;
+      next_ = {};
+
+      if (h)
+      {
+        prev_ = std::exchange(h->prev_, this);
+        prev_->next_ = this;
+      }
+      else
+      {
+        h = prev_ = this;
+      }
+    }
+
+    void unlink() noexcept
+    {
+      auto& h(*std::exchange(h_, {}));
+
+      if (this == h)
+      {
+        if ((h = next_)) h->prev_ = prev_;
+      }
+      else
+      {
+        prev_->next_ = next_;
+        (next_ ? next_ : h)->prev_ = prev_;
+      }
+    }
+
+  public:
+    explicit waiter(auto&& f) noexcept: f_(std::forward<decltype(f)>(f)) { }
+    ~waiter() { if (h_) unlink(); }
+
+    waiter(waiter const&) = delete;
+
+    //
+    waiter& operator=(waiter const&) = delete;
+  };
+
+  union slot
+  {
+    T v;
+
+    slot() noexcept { }
+    ~slot() { }
+  };
+
+  slot b_[N];
+
+  std::size_t h_{}, sz_{};
+
+  waiter* s_{}, *r_{};
+
+  bool closed_{};
+
+  void pop() noexcept
+  {
+    std::destroy_at(std::launder(&b_[h_].v));
+
+    h_ = (h_ + 1) % N;
+    --sz_;
+  }
+
+  static void wake(waiter* const w) noexcept
+  {
+    if (w) { w->unlink(); w->f_(); }
+  }
+
+  void wait(auto& c, waiter*& h)
+    noexcept(noexcept(c.pause()))
+  {
+    waiter w([&]() noexcept { c.unpause(); });
+
+    w.link(h);
+    c.pause();
+  }
+
+public:
+  channel() = default;
+
+  ~channel() { while (sz_) pop(); }
+
+  channel(channel const&) = delete;
+
+  //
+  channel& operator=(channel const&) = delete;
+
+  //
+  bool closed() const noexcept { return closed_; }
+  bool empty() const noexcept { return !sz_; }
+  bool full() const noexcept { return N == sz_; }
+  auto size() const noexcept { return sz_; }
+
+  static constexpr auto capacity() noexcept { return N; }
+
+  // wakes everyone, pending values can still be received
+  void close() noexcept
+  {
+    closed_ = true;
+
+    while (s_) wake(s_);
+    while (r_) wake(r_);
+  }
+
+  //
+  bool try_send(auto&& ...a)
+  {
+    if (closed_ || full())
+    {
+      return false;
+    }
+    else
+    {
+      ::new (&b_[(h_ + sz_) % N].v) T(std::forward<decltype(a)>(a)...);
+      ++sz_;
+
+      wake(r_);
+
+      return true;
+    }
+  }
+
+  std::optional<T> try_recv()
+  {
+    if (empty())
+    {
+      return {};
+    }
+    else
+    {
+      std::optional<T> r(std::move(*std::launder(&b_[h_].v)));
+      pop();
+
+      wake(s_);
+
+      return r;
+    }
+  }
+
+  //
+  // false, if the channel has been closed
+  bool send(auto& c, auto&& ...a)
+  {
+    for (;;)
+    {
+      if (closed_)
+      {
+        return false;
+      }
+      else if (full())
+      {
+        wait(c, s_);
+      }
+      else
+      {
+        return try_send(std::forward<decltype(a)>(a)...);
+      }
+    }
+  }
+
+  // an empty optional, if the channel has been closed and drained
+  std::optional<T> recv(auto& c)
+  {
+    for (;;)
+    {
+      if (!empty())
+      {
+        return try_recv();
+      }
+      else if (closed_)
+      {
+        return {};
+      }
+      else
+      {
+        wait(c, r_);
+      }
+    }
+  }
+};
+
+}
+
+#endif // CR2_CHANNEL_HPP
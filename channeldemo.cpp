@@ -0,0 +1,50 @@
+#include <iostream>
+
+#include "basic_coroutine.hpp"
+//#include "portable_coroutine.hpp"
+#include "libnone_support.hpp"
+
+#include "channel.hpp"
+
+using namespace cr2::literals;
+
+int main()
+{
+  cr2::channel<int, 4> ch;
+
+  auto const producer(
+    [&]() noexcept
+    {
+      return [&](auto& c)
+        {
+          for (int i{}; i != 10; ++i)
+          {
+            ch.send(c, i); // pauses, while the channel is full
+          }
+        };
+    }
+  );
+
+  std::cout <<
+    std::get<2>(
+      cr2::make_and_run<64_k, 64_k, 64_k>(
+        producer(),
+        producer(),
+        [&](auto& c)
+        {
+          int s{};
+
+          for (int n{}; n != 20; ++n)
+          {
+            s += *ch.recv(c);
+          }
+
+          ch.close();
+
+          return s;
+        }
+      )
+    ) << std::endl;
+
+  return 0;
+}
@@ -3,6 +3,8 @@
 # pragma once
 
 #include <cstddef> // std::size_t
+#include <chrono>
+#include <type_traits>
 
 namespace cr2
 {
@@ -11,6 +13,12 @@ enum : std::size_t { default_stack_size = 512 * 1024 };
 
 enum state {DEAD, RUNNING, PAUSED, NEW, SUSPENDED};
 
+template <class D>
+concept duration_c = requires(D d)
+  {
+    []<class A, class B>(std::chrono::duration<A, B>){}(d);
+  };
+
 namespace detail
 {
 
@@ -13,7 +13,8 @@
 namespace cr2
 {
 
-template <std::size_t S = default_stack_size>
+template <std::size_t S = default_stack_size,
+  template <std::size_t> class ...A>
 auto make_plain(auto&& f)
   noexcept(noexcept(
       coroutine<
@@ -22,12 +23,18 @@ auto make_plain(auto&& f)
           decltype(
             std::declval<std::remove_cvref_t<decltype(f)>>()(
               std::declval<
-                coroutine<std::remove_cvref_t<decltype(f)>, detail::empty_t, S>&
+                coroutine<
+                  std::remove_cvref_t<decltype(f)>,
+                  detail::empty_t,
+                  S,
+                  A...
+                >&
               >()
             )
           )
         >,
-        S
+        S,
+        A...
       >(std::forward<decltype(f)>(f))
     )
   )
@@ -35,41 +42,43 @@ auto make_plain(auto&& f)
   using F = std::remove_cvref_t<decltype(f)>;
   using R = detail::transform_void_t<
     decltype(std::declval<F>()(
-        std::declval<coroutine<F, detail::empty_t, S>&>()
+        std::declval<coroutine<F, detail::empty_t, S, A...>&>()
       )
     )
   >;
-  using C = coroutine<F, R, S>;
+  using C = coroutine<F, R, S, A...>;
 
   return C(std::forward<decltype(f)>(f));
 }
 
-template <std::size_t S = default_stack_size>
+template <std::size_t S = default_stack_size,
+  template <std::size_t> class ...A>
 auto make_shared(auto&& f)
 {
   using F = std::remove_cvref_t<decltype(f)>;
   using R = detail::transform_void_t<
     decltype(std::declval<F>()(
-        std::declval<coroutine<F, detail::empty_t, S>&>()
+        std::declval<coroutine<F, detail::empty_t, S, A...>&>()
       )
     )
   >;
-  using C = coroutine<F, R, S>;
+  using C = coroutine<F, R, S, A...>;
 
   return std::make_shared<C>(std::forward<decltype(f)>(f));
 }
 
-template <std::size_t S = default_stack_size>
+template <std::size_t S = default_stack_size,
+  template <std::size_t> class ...A>
 auto make_unique(auto&& f)
 {
   using F = std::remove_cvref_t<decltype(f)>;
   using R = detail::transform_void_t<
     decltype(std::declval<F>()(
-        std::declval<coroutine<F, detail::empty_t, S>&>()
+        std::declval<coroutine<F, detail::empty_t, S, A...>&>()
       )
     )
   >;
-  using C = coroutine<F, R, S>;
+  using C = coroutine<F, R, S, A...>;
 
   return std::make_unique<C>(std::forward<decltype(f)>(f));
 }
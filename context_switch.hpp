@@ -0,0 +1,145 @@
+#ifndef CR2_CONTEXT_SWITCH_HPP
+# define CR2_CONTEXT_SWITCH_HPP
+# pragma once
+
+#include <cstdint> // std::uintptr_t
+
+// switch_context() saves the callee-saved registers on the current stack,
+// stores the stack pointer into s, loads l and restores the registers saved
+// there. Everything else is saved by the caller, as with any function call.
+// The floating-point control registers are not switched.
+
+extern "C" void cr2_switch_context(void**, void*) noexcept;
+extern "C" void cr2_context_trampoline() noexcept;
+
+#if !defined(__ELF__)
+# error "CR2_ASM_SWITCH requires an ELF target"
+#elif defined(__amd64__) || defined(__amd64) || defined(__x86_64__) ||\
+  defined(__x86_64)
+asm(
+R"(.pushsection .text.cr2_switch_context,"axG",@progbits,cr2_switch_context,comdat
+  .weak cr2_switch_context
+  .hidden cr2_switch_context
+  .type cr2_switch_context, @function
+  .align 16
+cr2_switch_context:
+  pushq %rbp
+  pushq %rbx
+  pushq %r12
+  pushq %r13
+  pushq %r14
+  pushq %r15
+  movq %rsp, (%rdi)
+  movq %rsi, %rsp
+  popq %r15
+  popq %r14
+  popq %r13
+  popq %r12
+  popq %rbx
+  popq %rbp
+  popq %rax
+  jmpq *%rax
+  .size cr2_switch_context, .-cr2_switch_context
+  .popsection
+  .pushsection .text.cr2_context_trampoline,"axG",@progbits,cr2_context_trampoline,comdat
+  .weak cr2_context_trampoline
+  .hidden cr2_context_trampoline
+  .type cr2_context_trampoline, @function
+  .align 16
+cr2_context_trampoline:
+  movq %rbx, %rdi
+  callq *%r12
+  ud2
+  .size cr2_context_trampoline, .-cr2_context_trampoline
+  .popsection
+)"
+);
+#elif defined(__aarch64__)
+asm(
+R"(.pushsection .text.cr2_switch_context,"axG",@progbits,cr2_switch_context,comdat
+  .weak cr2_switch_context
+  .hidden cr2_switch_context
+  .type cr2_switch_context, %function
+  .align 4
+cr2_switch_context:
+  sub sp, sp, #160
+  stp d8, d9, [sp, #0]
+  stp d10, d11, [sp, #16]
+  stp d12, d13, [sp, #32]
+  stp d14, d15, [sp, #48]
+  stp x19, x20, [sp, #64]
+  stp x21, x22, [sp, #80]
+  stp x23, x24, [sp, #96]
+  stp x25, x26, [sp, #112]
+  stp x27, x28, [sp, #128]
+  stp x29, x30, [sp, #144]
+  mov x9, sp
+  str x9, [x0]
+  mov sp, x1
+  ldp d8, d9, [sp, #0]
+  ldp d10, d11, [sp, #16]
+  ldp d12, d13, [sp, #32]
+  ldp d14, d15, [sp, #48]
+  ldp x19, x20, [sp, #64]
+  ldp x21, x22, [sp, #80]
+  ldp x23, x24, [sp, #96]
+  ldp x25, x26, [sp, #112]
+  ldp x27, x28, [sp, #128]
+  ldp x29, x30, [sp, #144]
+  add sp, sp, #160
+  ret
+  .size cr2_switch_context, .-cr2_switch_context
+  .popsection
+  .pushsection .text.cr2_context_trampoline,"axG",@progbits,cr2_context_trampoline,comdat
+  .weak cr2_context_trampoline
+  .hidden cr2_context_trampoline
+  .type cr2_context_trampoline, %function
+  .align 4
+cr2_context_trampoline:
+  mov x0, x19
+  blr x20
+  brk #0
+  .size cr2_context_trampoline, .-cr2_context_trampoline
+  .popsection
+)"
+);
+#else
+# error "CR2_ASM_SWITCH is only available on x86-64 and aarch64"
+#endif
+
+namespace cr2::detail
+{
+
+inline void switch_context(void*& s, void* const l) noexcept
+{
+  cr2_switch_context(&s, l);
+}
+
+// the initial context "returns" into the trampoline, which calls f(a)
+inline void* make_context(void* const top, void* const a,
+  void (*const f)(void*) noexcept) noexcept
+{
+  auto const t(static_cast<std::uintptr_t*>(top));
+
+#if defined(__aarch64__)
+  auto const sp(t - 20); // d8-d15, x19-x30
+
+  sp[8] = reinterpret_cast<std::uintptr_t>(a); // x19
+  sp[9] = reinterpret_cast<std::uintptr_t>(f); // x20
+  sp[18] = 0; // x29
+  sp[19] = reinterpret_cast<std::uintptr_t>(&cr2_context_trampoline); // x30
+#else
+  auto const sp(t - 7); // r15, r14, r13, r12, rbx, rbp, return address
+
+  sp[3] = reinterpret_cast<std::uintptr_t>(f); // r12
+  sp[4] = reinterpret_cast<std::uintptr_t>(a); // rbx
+  sp[5] = 0; // rbp
+  sp[6] = reinterpret_cast<std::uintptr_t>(&cr2_context_trampoline);
+#endif
+
+  return sp;
+}
+
+}
+
+#endif // CR2_CONTEXT_SWITCH_HPP
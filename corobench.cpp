@@ -0,0 +1,192 @@
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+#if defined(CR2_BENCH_PORTABLE)
+# include "portable_coroutine.hpp"
+#else
+# include "basic_coroutine.hpp"
+#endif
+#include "common2.hpp"
+
+// prints "impl,bench,n,value,unit" lines, compare the output of both builds:
+//
+//   g++ -std=c++20 -Ofast corobench.cpp -o b && ./b
+//   g++ -std=c++20 -Ofast -DCR2_BENCH_PORTABLE corobench.cpp -o b -lboost_context
+//
+// an optional argument caps the largest population (default 1M)
+
+using namespace cr2::literals;
+
+namespace
+{
+
+#if defined(CR2_BENCH_PORTABLE)
+constexpr char impl[]{"portable"};
+#else
+constexpr char impl[]{"basic"};
+#endif
+
+constexpr std::size_t R(1000000); // repetitions of the micro benchmarks
+
+// the compiler must assume, that *p is read and written
+void escape(void* const p) noexcept
+{
+  asm volatile("" : : "g"(p) : "memory");
+}
+
+void report(char const* const b, std::size_t const n, double const v,
+  char const* const u)
+{
+  std::printf("%s,%s,%zu,%.2f,%s\n", impl, b, n, v, u);
+}
+
+double ns_per(std::size_t const n, auto&& f)
+{
+  auto const t0(std::chrono::steady_clock::now());
+
+  f();
+
+  return std::chrono::duration<double, std::nano>(
+    std::chrono::steady_clock::now() - t0).count() / n;
+}
+
+std::size_t resident() noexcept
+{
+  std::size_t sz{}, rss{};
+
+  std::ifstream("/proc/self/statm") >> sz >> rss;
+
+  return rss * sysconf(_SC_PAGESIZE);
+}
+
+template <std::size_t S = 64_k, template <std::size_t> class ...A>
+auto make_looper()
+{
+  return cr2::make_plain<S, A...>(
+      [](auto& c)
+      {
+        for (;;) c.suspend();
+      }
+    );
+}
+
+void switches()
+{
+  auto c(make_looper());
+
+  c();
+
+  report("resume_suspend", 1, ns_per(R, [&]() noexcept
+      {
+        for (auto i(R); i; --i) c();
+      }
+    ), "ns"
+  );
+}
+
+template <template <std::size_t> class ...A>
+void create_destroy(char const* const b)
+{ // run to the first suspend, else there is next to nothing to construct
+  report(b, 1, ns_per(R, []()
+      {
+        for (auto i(R); i; --i)
+        {
+          auto c(make_looper<64_k, A...>());
+
+          escape(&c);
+          c();
+        }
+      }
+    ), "ns"
+  );
+}
+
+void creation()
+{
+  create_destroy("create_start_destroy");
+  create_destroy<cr2::pooled_stack>("create_start_destroy_pooled");
+
+  // reset, then run to the first suspend
+  auto c(make_looper());
+
+  report("reset_start", 1, ns_per(R, [&]() noexcept
+      {
+        for (auto i(R); i; --i) { c.reset(); c(); }
+      }
+    ), "ns"
+  );
+}
+
+void transfers()
+{
+  auto b(make_looper());
+
+  auto a(cr2::make_plain<64_k>(
+      [&](auto& c)
+      {
+        for (;;) c.suspend_to(b);
+      }
+    )
+  );
+
+  a();
+
+  // a -> b -> caller
+  report("suspend_to", 1, ns_per(R, [&]() noexcept
+      {
+        for (auto i(R); i; --i) a();
+      }
+    ), "ns"
+  );
+}
+
+void population(std::size_t const n)
+{ // small heap stacks, so that 1M coroutines fit into memory
+  using C = decltype(make_looper<16_k, cr2::heap_stack>());
+
+  auto const rss0(resident());
+
+  std::vector<C> v;
+  v.reserve(n);
+
+  for (auto i(n); i; --i) v.push_back(make_looper<16_k, cr2::heap_stack>());
+
+  for (auto& c: v) c(); // every stack is touched
+
+  auto const rss1(resident());
+
+  // every coroutine is resumed the same number of times
+  auto const k(std::max(R / n, std::size_t(1)));
+
+  report("resume_suspend", n, ns_per(k * n, [&]() noexcept
+      {
+        for (auto i(k); i; --i) for (auto& c: v) c();
+      }
+    ), "ns"
+  );
+
+  report("sizeof", n, sizeof(C), "B");
+  report("resident", n, double(rss1 - std::min(rss0, rss1)) / n, "B");
+}
+
+}
+
+int main(int const argc, char* argv[])
+{
+  auto const m(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000);
+
+  std::printf("impl,bench,n,value,unit\n");
+
+  switches();
+  creation();
+  transfers();
+
+  for (std::size_t n(1); n <= m; n *= 1000) population(n);
+
+  return 0;
+}
@@ -46,7 +46,7 @@ int main()
     ) <<
     std::endl;
 
-  event_base_free(cr2::base);
+  event_base_free(std::exchange(cr2::base, {}));
   libevent_global_shutdown();
 
   return 0;
@@ -0,0 +1,248 @@
+#ifndef CR2_CURL_SUPPORT_HPP
+# define CR2_CURL_SUPPORT_HPP
+# pragma once
+
+#include "curl/curl.h"
+
+#include <cstdint> // std::intptr_t
+
+// the transfers run on the libuv loop, if libuv_support.hpp is included
+// before this header, else on the libevent loop
+#if !defined(CR2_LIBUV_SUPPORT_HPP)
+# include "libevent_support.hpp"
+#endif
+
+namespace cr2
+{
+
+namespace detail::curl
+{
+
+// the transfers of a thread share a single multi handle, curl tells us,
+// which sockets to watch and when to time out, the loop tells curl, when
+// something happened
+inline thread_local CURLM* multi;
+
+inline thread_local int running;
+
+inline void check_info() noexcept
+{
+  int n;
+
+  while (auto const m = curl_multi_info_read(multi, &n))
+  {
+    if (CURLMSG_DONE == m->msg)
+    {
+      auto const h(m->easy_handle);
+      auto const r(m->data.result);
+
+      gnr::forwarder<void(CURLcode) noexcept>* g;
+      curl_easy_getinfo(h, CURLINFO_PRIVATE, &g);
+
+      curl_multi_remove_handle(multi, h);
+
+      (*g)(r);
+    }
+  }
+}
+
+#if defined(CR2_LIBUV_SUPPORT_HPP)
+inline thread_local uv_timer_t timer;
+
+extern "C"
+{
+
+inline void curl_timer_cb(uv_timer_t*) noexcept
+{
+  curl_multi_socket_action(multi, CURL_SOCKET_TIMEOUT, 0, &running);
+  check_info();
+}
+
+inline void curl_poll_cb(uv_poll_t* const p, int const status,
+  int const events) noexcept
+{
+  curl_multi_socket_action(multi,
+    curl_socket_t(reinterpret_cast<std::intptr_t>(p->data)),
+    status < 0 ? CURL_CSELECT_ERR :
+      (UV_READABLE & events ? CURL_CSELECT_IN : 0) |
+      (UV_WRITABLE & events ? CURL_CSELECT_OUT : 0),
+    &running
+  );
+
+  check_info();
+}
+
+inline void curl_close_cb(uv_handle_t* const uvh) noexcept
+{
+  delete reinterpret_cast<uv_poll_t*>(uvh);
+}
+
+// a poll handle per socket, the socket is kept in its data
+inline int socket_function(CURL*, curl_socket_t const s, int const what,
+  void*, void* const sp) noexcept
+{
+  auto p(static_cast<uv_poll_t*>(sp));
+
+  if (CURL_POLL_REMOVE == what)
+  {
+    if (p) uv_close(reinterpret_cast<uv_handle_t*>(p), curl_close_cb);
+  }
+  else
+  {
+    if (!p)
+    {
+      uv_poll_init_socket(loop, p = new uv_poll_t, s);
+      p->data = reinterpret_cast<void*>(std::intptr_t(s));
+
+      curl_multi_assign(multi, s, p);
+    }
+
+    uv_poll_start(p,
+      (CURL_POLL_IN & what ? UV_READABLE : 0) |
+      (CURL_POLL_OUT & what ? UV_WRITABLE : 0),
+      curl_poll_cb
+    );
+  }
+
+  return 0;
+}
+
+inline int timer_function(CURLM*, long const ms, void*) noexcept
+{
+  if (ms < 0)
+  {
+    uv_timer_stop(&timer);
+  }
+  else
+  {
+    uv_timer_start(&timer, curl_timer_cb, ms, 0);
+  }
+
+  return 0;
+}
+
+}
+#else
+inline thread_local timer_wheel::timer timer(
+  []() noexcept
+  {
+    curl_multi_socket_action(multi, CURL_SOCKET_TIMEOUT, 0, &running);
+    check_info();
+  }
+);
+
+extern "C"
+{
+
+inline void event_cb(evutil_socket_t const s, short const f, void*) noexcept
+{
+  curl_multi_socket_action(multi, s,
+    (EV_READ & f ? CURL_CSELECT_IN : 0) |
+    (EV_WRITE & f ? CURL_CSELECT_OUT : 0),
+    &running
+  );
+
+  check_info();
+}
+
+inline int socket_function(CURL*, curl_socket_t const s, int const what,
+  void*, void* const sp) noexcept
+{
+  auto ev(static_cast<struct event*>(sp));
+
+  if (CURL_POLL_REMOVE == what)
+  { // curl may remove a socket, that it never asked us to watch
+    if (ev) event_free(ev);
+  }
+  else
+  {
+    short const f(
+      (CURL_POLL_IN & what ? EV_READ : 0) |
+      (CURL_POLL_OUT & what ? EV_WRITE : 0) |
+      EV_PERSIST
+    );
+
+    if (ev)
+    {
+      event_del(ev);
+      event_assign(ev, base, s, f, event_cb, {});
+    }
+    else
+    {
+      curl_multi_assign(multi, s, ev = event_new(base, s, f, event_cb, {}));
+    }
+
+    event_add(ev, {});
+  }
+
+  return 0;
+}
+
+inline int timer_function(CURLM*, long const ms, void*) noexcept
+{
+  if (ms < 0)
+  {
+    if (timer) timers.remove(timer);
+  }
+  else
+  {
+    timers.add(timer, std::chrono::milliseconds(ms));
+  }
+
+  return 0;
+}
+
+}
+#endif
+
+inline CURLM* multi_handle() noexcept
+{
+  if (!multi)
+  {
+    multi = curl_multi_init();
+
+#if defined(CR2_LIBUV_SUPPORT_HPP)
+    uv_timer_init(loop, &timer);
+#endif
+
+    curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, socket_function);
+    curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, timer_function);
+  }
+
+  return multi;
+}
+
+}
+
+// performs the transfer of an easy handle, without blocking the thread;
+// returns the result of the transfer
+template <auto G>
+CURLcode await(auto& c, CURL* const h)
+  noexcept(noexcept(c.pause()))
+  requires(G == curl_easy_perform)
+{
+  CURLcode r;
+
+  gnr::forwarder<void(CURLcode) noexcept> g(
+    [&](CURLcode const e) noexcept
+    {
+      r = e;
+      c.unpause();
+    }
+  );
+
+  curl_easy_setopt(h, CURLOPT_PRIVATE, &g);
+
+  if (CURLM_OK != curl_multi_add_handle(detail::curl::multi_handle(), h))
+  {
+    return CURLE_FAILED_INIT;
+  }
+
+  c.pause();
+
+  return r;
+}
+
+}
+
+#endif // CR2_CURL_SUPPORT_HPP
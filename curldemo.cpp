@@ -1,12 +1,10 @@
-#include "curl/curl.h"
-
 #include <iostream>
 
 #include "generic/forwarder.hpp"
 
 #include "basic_coroutine.hpp"
 //#include "portable_coroutine.hpp"
-#include "libnone_support.hpp"
+#include "curl_support.hpp"
 
 namespace curl
 {
@@ -34,15 +32,18 @@ auto get(auto& c, std::string_view const& url)
   gnr::forwarder<std::size_t(char const*, std::size_t)> f(
     [&](char const* const buffer, std::size_t const sz)
     {
-      return s.append(buffer, sz), c.suspend(), sz;
+      return s.append(buffer, sz), sz;
     }
   );
 
   curl_easy_setopt(h, CURLOPT_WRITEDATA, &f);
   curl_easy_setopt(h, CURLOPT_WRITEFUNCTION, c_get);
 
-  c.suspend();
-  curl_easy_perform(h);
+  // dns, connect, tls and the transfer itself run on the event loop
+  if (auto const r(cr2::await<curl_easy_perform>(c, h)); CURLE_OK != r)
+  {
+    s = curl_easy_strerror(r);
+  }
 
   curl_easy_cleanup(h);
 
@@ -66,7 +67,7 @@ int main()
           std::cout << "coro0\n";
 
           j *= i;
-          c.suspend();
+          cr2::await(c, std::chrono::milliseconds(10));
         }
 
         return j;
@@ -0,0 +1,260 @@
+#ifndef CR2_EPOLL_SUPPORT_HPP
+# define CR2_EPOLL_SUPPORT_HPP
+# pragma once
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <iterator> // std::size
+#include <utility> // std::exchange
+#include <vector>
+
+#include "common2.hpp"
+#include "timer_wheel.hpp"
+
+namespace cr2
+{
+
+// every thread, that runs a loop, has its own epoll instance; an instance,
+// that run() created, is closed, when the thread exits, unless it was
+// closed and reset before
+static inline thread_local int epfd{-1};
+
+namespace detail
+{
+
+inline int make_epoll() noexcept
+{
+  static thread_local struct owner
+  {
+    ~owner() { if (-1 != epfd) close(std::exchange(epfd, -1)); }
+  } o;
+
+  return epoll_create1(EPOLL_CLOEXEC);
+}
+
+struct epoll_slot
+{
+  gnr::forwarder<void(std::uint32_t) noexcept>* r_{}, *w_{};
+
+  std::uint32_t ready_{}; // latched edges
+  bool registered_{};
+};
+
+constexpr std::uint32_t EPOLL_ERRORS{EPOLLERR | EPOLLHUP | EPOLLRDHUP};
+
+static inline thread_local std::vector<epoll_slot> epoll_slots; // by fd
+static inline thread_local std::size_t epoll_waiters;
+
+inline auto& epoll_slot(int const fd)
+{
+  if (std::size_t(fd) >= epoll_slots.size())
+  {
+    epoll_slots.resize(fd + 1);
+  }
+
+  auto& s(epoll_slots[fd]);
+
+  if (!s.registered_)
+  { // every fd is registered once, edge-triggered, for both directions; an
+    // fd, that is still in the epoll set, is re-armed instead
+    struct epoll_event e{
+      .events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET,
+      .data = {.fd = fd}
+    };
+
+    s.registered_ = !epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &e) ||
+      ((EEXIST == errno) && !epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &e));
+  }
+
+  return s;
+}
+
+inline std::uint32_t epoll_await(auto& c, std::uint32_t ev, int const fd,
+  auto const d)
+  noexcept(noexcept(c.pause()))
+{
+  ev |= EPOLL_ERRORS;
+
+  if (fd < 0)
+  {
+    return EPOLLERR;
+  }
+  else if (auto& s(epoll_slot(fd)); !s.registered_)
+  {
+    return EPOLLERR;
+  }
+  else if (auto const m(s.ready_ & ev); m)
+  { // consume the latched edge
+    s.ready_ &= ~(m & (EPOLLIN | EPOLLOUT));
+
+    return m;
+  }
+  else
+  {
+    std::uint32_t r{};
+
+    gnr::forwarder<void(std::uint32_t) noexcept> f(
+      [&](auto const e) noexcept
+      {
+        r = e & ev;
+        c.unpause();
+      }
+    );
+
+    timer_wheel::timer t([&]() noexcept { c.unpause(); });
+
+    if (EPOLLIN & ev) s.r_ = &f;
+    if (EPOLLOUT & ev) s.w_ = &f;
+
+    if constexpr(duration_c<decltype(d)>)
+    {
+      timers.add(t, d);
+    }
+
+    ++epoll_waiters;
+    c.pause();
+    --epoll_waiters;
+
+    {
+      auto& s(epoll_slots[fd]); // the slots may have moved
+
+      if (&f == s.r_) s.r_ = {};
+      if (&f == s.w_) s.w_ = {};
+
+      s.ready_ &= ~(r & (EPOLLIN | EPOLLOUT));
+    }
+
+    return r;
+  }
+}
+
+}
+
+// the fd must be forgotten before it is closed, fds are registered once, a
+// reused number, that was not forgotten, is never added to the epoll set
+inline void forget(int const fd) noexcept
+{
+  if (std::size_t(fd) < detail::epoll_slots.size())
+  {
+    if (detail::epoll_slots[fd].registered_)
+    {
+      epoll_ctl(epfd, EPOLL_CTL_DEL, fd, {});
+    }
+
+    detail::epoll_slots[fd] = {};
+  }
+}
+
+// returns the ready events
+std::uint32_t await(auto& c, std::uint32_t const ev, int const fd)
+  noexcept(noexcept(c.pause()))
+{
+  return detail::epoll_await(c, ev, fd, nullptr);
+}
+
+// returns the ready events, 0 on timeout
+std::uint32_t await(auto& c, duration_c auto const d,
+  std::uint32_t const ev, int const fd)
+  noexcept(noexcept(c.pause()))
+{
+  return detail::epoll_await(c, ev, fd, d);
+}
+
+bool await(auto& c, duration_c auto const d)
+  noexcept(noexcept(c.pause()))
+{
+  timer_wheel::timer t([&]() noexcept { c.unpause(); });
+
+  timers.add(t, d);
+  c.pause();
+
+  return false;
+}
+
+auto run(auto&& ...c)
+  noexcept(noexcept((c.template retval<>(), ...)))
+  requires(sizeof...(c) >= 1)
+{
+  {
+    auto const e(-1 == epfd ? epfd = detail::make_epoll() : epfd);
+
+    detail::ready_queue q;
+
+    q.attach(c...); // detached, when q goes out of scope
+
+    for (;;)
+    {
+      q();
+
+      if (!q.poll())
+      { // cpu-bound coroutines are ready, the reactor can wait
+        continue;
+      }
+      else if (q || (q.paused() && (detail::epoll_waiters || timers)))
+      {
+        struct epoll_event ev[64];
+
+        for (auto n(epoll_wait(e, ev, std::size(ev),
+          q ? 0 : timers.timeout())); n > 0;)
+        {
+          auto& s(detail::epoll_slots[ev[--n].data.fd]);
+
+          s.ready_ |= ev[n].events;
+
+          auto const wake([&](auto const f, std::uint32_t const m) noexcept
+            {
+              if (f && (s.ready_ & m))
+              {
+                if (f == s.r_) s.r_ = {};
+                if (f == s.w_) s.w_ = {};
+
+                (*f)(s.ready_);
+              }
+            }
+          );
+
+          wake(s.r_, EPOLLIN | detail::EPOLL_ERRORS);
+          wake(s.w_, EPOLLOUT | detail::EPOLL_ERRORS);
+        }
+
+        timers.advance();
+      }
+      else
+      {
+        break;
+      }
+    }
+  }
+
+  if constexpr(sizeof...(c) > 1)
+  {
+    return std::tuple<decltype(c.template retval<true>())...>{
+      c.template retval<true>()...
+    };
+  }
+  else
+  {
+    return (c, ...).template retval<>();
+  }
+}
+
+auto make_and_run(auto&& ...c)
+  noexcept(noexcept(run(make_plain(std::forward<decltype(c)>(c))...)))
+{
+  return run(make_plain(std::forward<decltype(c)>(c))...);
+}
+
+template <std::size_t ...S>
+auto make_and_run(auto&& ...c)
+  noexcept(noexcept(run(make_plain(std::forward<decltype(c)>(c))...)))
+  requires(sizeof...(S) == sizeof...(c))
+{
+  return run(make_plain<S>(std::forward<decltype(c)>(c))...);
+}
+
+}
+
+#endif // CR2_EPOLL_SUPPORT_HPP
@@ -0,0 +1,82 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <iostream>
+
+#include "basic_coroutine.hpp"
+//#include "portable_coroutine.hpp"
+#include "epoll_support.hpp"
+
+using namespace cr2::literals;
+using namespace std::literals::chrono_literals;
+
+int main()
+{
+  int sv[2];
+
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv))
+  {
+    return 1;
+  }
+
+  std::cout <<
+    std::get<0>(
+      cr2::make_and_run<64_k, 64_k, 64_k>(
+        [&](auto& c)
+        {
+          std::string r;
+
+          // nothing was written yet, the await times out
+          std::cout << "reader " <<
+            cr2::await(c, 50ms, EPOLLIN, sv[0]) << '\n';
+
+          for (char buf[64];;)
+          {
+            if (auto const sz(read(sv[0], buf, sizeof(buf))); sz > 0)
+            {
+              r.append(buf, sz);
+            }
+            else if (!sz || (EAGAIN != errno) ||
+              (EPOLLIN & ~cr2::await(c, EPOLLIN, sv[0])))
+            {
+              break;
+            }
+          }
+
+          return r;
+        },
+        [&](auto& c)
+        {
+          for (unsigned i{}; i != 3; ++i)
+          {
+            cr2::await(c, 100ms);
+            std::cout << "writer " << i << '\n';
+            write(sv[1], "hello ", 6);
+          }
+
+          cr2::forget(sv[1]);
+          close(sv[1]);
+        },
+        [](auto& c)
+        {
+          std::uintmax_t j(5);
+
+          for (auto i(j - 1); 1 != i; --i)
+          {
+            std::cout << "coro2\n";
+
+            j *= i;
+            c.suspend();
+          }
+
+          return j;
+        }
+      )
+    ) <<
+    std::endl;
+
+  cr2::forget(sv[0]);
+  close(sv[0]);
+
+  return 0;
+}
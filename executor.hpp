@@ -0,0 +1,286 @@
+#ifndef CR2_EXECUTOR_HPP
+# define CR2_EXECUTOR_HPP
+# pragma once
+
+#include <algorithm> // std::max
+#include <atomic>
+#include <deque>
+#include <memory> // std::unique_ptr
+#include <mutex>
+#include <thread>
+
+#include "common.hpp"
+
+namespace cr2
+{
+
+// M:N executor, one worker thread per core, every worker owns a deque of
+// ready coroutines and steals from the others, when its own runs dry;
+// a coroutine may resume on a different thread after it suspends, so it
+// must not hold on to thread-local state across suspension points
+class executor
+{
+public:
+  class task
+  {
+    friend class executor;
+
+  private:
+    enum : unsigned char { QUEUED, RUNNING, PARKED, WOKEN = 4 };
+
+    std::atomic<unsigned char> s_{QUEUED};
+
+    executor& e_;
+
+    void* c_;
+
+    void (*invoke_)(void*);
+    enum state (*state_)(void*) noexcept;
+    void (*unpause_)(void*) noexcept;
+    void (*destroy_)(void*) noexcept;
+
+  public:
+    template <typename C>
+    task(executor& e, std::unique_ptr<C>&& c) noexcept:
+      e_(e),
+      c_(c.release())
+    {
+      invoke_ = [](void* const p) { (*static_cast<C*>(p))(); };
+      state_ = [](void* const p) noexcept {return static_cast<C*>(p)->state();};
+      unpause_ = [](void* const p) noexcept { static_cast<C*>(p)->unpause(); };
+      destroy_ = [](void* const p) noexcept { delete static_cast<C*>(p); };
+    }
+
+    ~task() { destroy_(c_); }
+
+    task(task const&) = delete;
+
+    //
+    task& operator=(task const&) = delete;
+
+    //
+    void const* id() const noexcept { return c_; }
+
+    // thread-safe, a wakeup, that arrives while the coroutine is not
+    // paused, is not lost, the next pause returns right away
+    void unpause() noexcept { e_.wake(this); }
+  };
+
+private:
+  struct alignas(64) worker
+  {
+    executor* e_;
+
+    std::mutex m_;
+    std::deque<task*> q_;
+
+    std::thread t_;
+  };
+
+  std::size_t const n_;
+  std::unique_ptr<worker[]> w_;
+
+  alignas(64) std::atomic<std::size_t> live_{};
+  alignas(64) std::atomic<std::size_t> signal_{};
+  std::atomic<std::size_t> next_{};
+
+  std::atomic<bool> stop_{};
+
+  // shared by all executors, a worker of one may push tasks of another
+  static inline thread_local worker* this_worker_;
+  static inline thread_local task* this_task_;
+
+  //
+  void notify() noexcept
+  {
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_one();
+  }
+
+  void push(task* const t)
+  {
+    auto const w(this_worker_ && (this == this_worker_->e_) ? this_worker_ :
+      &w_[next_.fetch_add(1, std::memory_order_relaxed) % n_]);
+
+    {
+      std::lock_guard l(w->m_);
+
+      w->q_.push_back(t);
+    }
+
+    notify();
+  }
+
+  task* pop(worker& w)
+  {
+    {
+      std::lock_guard l(w.m_);
+
+      if (!w.q_.empty())
+      {
+        auto const t(w.q_.front());
+        w.q_.pop_front();
+
+        return t;
+      }
+    }
+
+    // steal from the back of the other deques
+    for (std::size_t i(1); i != n_; ++i)
+    {
+      auto& v(w_[(&w - w_.get() + i) % n_]);
+
+      if (std::unique_lock l(v.m_, std::try_to_lock); l && !v.q_.empty())
+      {
+        auto const t(v.q_.back());
+        v.q_.pop_back();
+
+        return t;
+      }
+    }
+
+    return {};
+  }
+
+  void wake(task* const t)
+  {
+    for (auto s(t->s_.load(std::memory_order_acquire));;)
+    {
+      if (task::PARKED == s)
+      {
+        if (t->s_.compare_exchange_weak(s, task::QUEUED,
+          std::memory_order_acq_rel))
+        {
+          t->unpause_(t->c_);
+          push(t);
+
+          break;
+        }
+      }
+      else if ((task::WOKEN & s) || t->s_.compare_exchange_weak(s,
+        s | task::WOKEN, std::memory_order_acq_rel))
+      { // the wakeup is consumed, when the coroutine pauses next
+        break;
+      }
+    }
+  }
+
+  void work(worker& w)
+  {
+    this_worker_ = &w;
+
+    for (;;)
+    {
+      auto const s(signal_.load(std::memory_order_acquire));
+
+      if (auto const t(pop(w)); t)
+      {
+        t->s_.fetch_or(task::RUNNING, std::memory_order_acq_rel);
+
+        this_task_ = t;
+        t->invoke_(t->c_);
+        this_task_ = {};
+
+        switch (t->state_(t->c_))
+        {
+          case DEAD:
+            delete t;
+
+            if (1 == live_.fetch_sub(1, std::memory_order_acq_rel))
+            {
+              live_.notify_all();
+            }
+
+            break;
+
+          case PAUSED:
+            if (unsigned char r(task::RUNNING); t->s_.compare_exchange_strong(
+              r, task::PARKED, std::memory_order_acq_rel))
+            {
+              break;
+            }
+
+            t->s_.store(task::QUEUED, std::memory_order_release);
+            t->unpause_(t->c_); // woken, before it paused
+            push(t);
+
+            break;
+
+          default:
+            t->s_.fetch_and(task::WOKEN, std::memory_order_acq_rel);
+            push(t);
+        }
+      }
+      else if (stop_.load(std::memory_order_acquire))
+      {
+        break;
+      }
+      else
+      {
+        signal_.wait(s, std::memory_order_acquire);
+      }
+    }
+
+    this_worker_ = {};
+  }
+
+public:
+  explicit executor(std::size_t const n =
+    std::max(1u, std::thread::hardware_concurrency())):
+    n_(n),
+    w_(new worker[n])
+  {
+    for (std::size_t i{}; i != n_; ++i)
+    {
+      w_[i].e_ = this;
+      w_[i].t_ = std::thread([this, i]() { work(w_[i]); });
+    }
+  }
+
+  ~executor()
+  {
+    join();
+
+    stop_.store(true, std::memory_order_release);
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_all();
+
+    for (std::size_t i{}; i != n_; ++i)
+    {
+      w_[i].t_.join();
+    }
+  }
+
+  executor(executor const&) = delete;
+
+  //
+  executor& operator=(executor const&) = delete;
+
+  //
+  static task* current() noexcept { return this_task_; }
+
+  // blocks, until all spawned coroutines are DEAD
+  void join() noexcept
+  {
+    for (std::size_t l; (l = live_.load(std::memory_order_acquire));)
+    {
+      live_.wait(l, std::memory_order_acquire);
+    }
+  }
+
+  // the task is deleted together with the coroutine, once it is DEAD
+  template <typename C>
+  task& spawn(std::unique_ptr<C>&& c)
+  {
+    auto const t(new task(*this, std::move(c)));
+
+    live_.fetch_add(1, std::memory_order_relaxed);
+    push(t);
+
+    return *t;
+  }
+};
+
+}
+
+#endif // CR2_EXECUTOR_HPP
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <thread>
+
+#include "basic_coroutine.hpp"
+//#include "portable_coroutine.hpp"
+#include "common2.hpp"
+#include "executor.hpp"
+
+using namespace cr2::literals;
+
+int main()
+{
+  std::atomic<std::uintmax_t> r{};
+
+  cr2::executor e;
+
+  for (unsigned k{}; k != 1000; ++k)
+  {
+    e.spawn(
+      cr2::make_unique<64_k, cr2::pooled_stack>(
+        [&, k](auto& c)
+        {
+          std::uintmax_t j(1);
+
+          for (auto i(k % 20 + 1); i; --i)
+          {
+            j *= i;
+            c.suspend(); // may resume on another worker
+          }
+
+          r += j;
+        }
+      )
+    );
+  }
+
+  auto& t(
+    e.spawn(
+      cr2::make_unique<64_k, cr2::pooled_stack>(
+        [](auto& c)
+        {
+          std::cout << "pausing\n";
+          c.pause();
+          std::cout << "unpaused\n";
+        }
+      )
+    )
+  );
+
+  std::thread([&]() noexcept { t.unpause(); }).join();
+
+  e.join();
+
+  std::cout << r << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,160 @@
+#ifndef CR2_FD_WRITER_HPP
+# define CR2_FD_WRITER_HPP
+# pragma once
+
+#include "libevent_support.hpp"
+
+namespace cr2
+{
+
+// coalesces the writes of several coroutines to the same fd; a writer
+// queues its buffers, without copying them, and pauses; the first writer
+// leads, it yields once, so that the coroutines running during the same
+// tick can queue their writes too, then it writes the whole queue with as
+// few syscalls as partial writes allow; every writer is unpaused, once its
+// buffers went out, and the leader hands the lead over, once its own did;
+// the buffers of different writers are never interleaved
+class fd_writer
+{
+private:
+  struct request
+  {
+    detail::iov_cursor v;
+
+    gnr::forwarder<void() noexcept>* f;
+    request* next{};
+
+    ssize_t r{};
+    int e{};
+
+    bool lead{};
+  };
+
+  fd_event& e_;
+
+  request* h_{}, *t_{};
+
+  request* pop() noexcept
+  {
+    auto const q(h_);
+
+    if (!(h_ = q->next)) t_ = {};
+
+    return q;
+  }
+
+  // the head requests, that were written, are done
+  void complete(request& self, std::size_t s) noexcept
+  {
+    while (h_)
+    {
+      auto& q(*h_);
+
+      auto const l(q.v.advance(s));
+      q.r += s - l;
+      s = l;
+
+      if (!q.v.done()) break;
+
+      if (&self != pop()) (*q.f)();
+    }
+  }
+
+  void fail(request& self, int const e) noexcept
+  {
+    while (h_)
+    {
+      auto const q(pop());
+
+      q->r = -1;
+      q->e = e;
+
+      if (&self != q) (*q->f)();
+    }
+  }
+
+  void lead(auto& c, request& self)
+  {
+    while (!self.v.done())
+    {
+      struct iovec iov[64];
+      std::size_t k{};
+
+      for (auto q(h_); q && (std::size(iov) != k); q = q->next)
+      {
+        k += q->v.gather(&iov[k], std::size(iov) - k);
+      }
+
+      if (auto const sz(detail::writev(e_.fd(), iov, k)); -1 != sz)
+      {
+        complete(self, sz);
+      }
+      else if (EINTR == errno)
+      {
+        continue;
+      }
+      else if ((EAGAIN == errno) || (EWOULDBLOCK == errno))
+      {
+        await(c, e_, EV_WRITE);
+      }
+      else
+      {
+        fail(self, errno);
+
+        break;
+      }
+    }
+
+    if (h_) // hand the lead over
+    {
+      h_->lead = true;
+      (*h_->f)();
+    }
+  }
+
+public:
+  explicit fd_writer(fd_event& e) noexcept: e_(e) { }
+
+  fd_writer(fd_writer const&) = delete;
+
+  //
+  fd_writer& operator=(fd_writer const&) = delete;
+
+  // returns the number of bytes written, or -1 with errno set
+  ssize_t write(auto& c, std::span<struct iovec const> const v)
+  {
+    gnr::forwarder<void() noexcept> f([&]() noexcept { c.unpause(); });
+
+    request r{{v.data(), v.size()}, &f};
+
+    (t_ ? t_->next : h_) = &r;
+    t_ = &r;
+
+    if (&r == h_)
+    { // collect the writes of this tick
+      c.suspend();
+    }
+    else
+    {
+      c.pause();
+    }
+
+    if ((&r == h_) || r.lead) lead(c, r);
+
+    if (-1 == r.r) errno = r.e;
+
+    return r.r;
+  }
+
+  ssize_t write(auto& c, iovec_c auto const& ...v)
+    requires(bool(sizeof...(v)))
+  {
+    struct iovec const iov[]{v...};
+
+    return write(c, std::span(iov));
+  }
+};
+
+}
+
+#endif // CR2_FD_WRITER_HPP
@@ -0,0 +1,118 @@
+#ifndef CR2_GENERATOR_HPP
+# define CR2_GENERATOR_HPP
+# pragma once
+
+#include <iterator> // std::default_sentinel_t, std::input_iterator_tag
+#include <optional>
+
+#include "generic/forwarder.hpp"
+
+#include "common.hpp"
+
+namespace cr2
+{
+
+// a coroutine, that is pulled by its consumer, every yielded value is
+// stored in an inline slot, until the next pull
+template <typename T, std::size_t S = default_stack_size,
+  template <std::size_t> class ...A>
+class generator
+{
+  static_assert(!std::is_reference_v<T>);
+
+private:
+  struct body
+  {
+    generator& g_;
+    gnr::forwarder<void(generator&)> f_;
+
+    void operator()(auto&) { f_(g_); }
+  };
+
+  std::optional<T> v_;
+
+  coroutine<body, detail::empty_t, S, A...> c_;
+
+public:
+  class iterator
+  {
+  private:
+    generator* g_;
+
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = T;
+    using pointer = T*;
+    using reference = T&;
+
+    explicit iterator(generator& g) noexcept: g_(&g) { }
+
+    //
+    bool operator==(std::default_sentinel_t) const noexcept
+    {
+      return !g_->v_;
+    }
+
+    reference operator*() const noexcept { return *g_->v_; }
+    pointer operator->() const noexcept { return &*g_->v_; }
+
+    iterator& operator++() { g_->next(); return *this; }
+    void operator++(int) { g_->next(); }
+  };
+
+  explicit generator(auto&& f):
+    c_(body{*this, std::forward<decltype(f)>(f)})
+  {
+  }
+
+  generator(generator const&) = delete;
+  generator& operator=(generator const&) = delete;
+
+  //
+  explicit operator bool() const noexcept { return c_.state(); }
+
+  //
+  auto begin()
+  {
+    if (NEW == c_.state()) next();
+
+    return iterator(*this);
+  }
+
+  auto end() const noexcept { return std::default_sentinel; }
+
+  // pull the next value, nullptr means the generator has returned
+  T* next()
+  {
+    v_.reset();
+
+    if (c_.state() >= NEW) c_();
+
+    return v_ ? &*v_ : nullptr;
+  }
+
+  void reset()
+  {
+    v_.reset();
+    c_.reset();
+  }
+
+  // called from within the generator
+  void yield(auto&& ...a)
+  {
+    v_.emplace(std::forward<decltype(a)>(a)...);
+    c_.suspend();
+  }
+};
+
+template <typename T, std::size_t S = default_stack_size,
+  template <std::size_t> class ...A>
+auto make_generator(auto&& f)
+{
+  return generator<T, S, A...>(std::forward<decltype(f)>(f));
+}
+
+}
+
+#endif // CR2_GENERATOR_HPP
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <string_view>
+
+#include "basic_coroutine.hpp"
+//#include "portable_coroutine.hpp"
+#include "generator.hpp"
+
+using namespace cr2::literals;
+
+int main()
+{
+  auto fib(
+    cr2::make_generator<std::uintmax_t, 64_k>(
+      [](auto& g)
+      {
+        for (std::uintmax_t a{}, b(1); a < 1000; b += a, a = b - a)
+        {
+          g.yield(a);
+        }
+      }
+    )
+  );
+
+  for (auto const i: fib) std::cout << i << ' ';
+  std::cout << std::endl;
+
+  // a lazy pipeline: split text into lines, then lines into words
+  auto lines(
+    cr2::make_generator<std::string_view, 64_k>(
+      [](auto& g)
+      {
+        std::string_view s("lorem ipsum\ndolor sit amet\nconsectetur");
+
+        for (std::size_t i; std::string_view::npos != (i = s.find('\n'));)
+        {
+          g.yield(s.substr(0, i));
+          s.remove_prefix(i + 1);
+        }
+
+        g.yield(s);
+      }
+    )
+  );
+
+  auto words(
+    cr2::make_generator<std::string_view, 64_k>(
+      [&](auto& g)
+      {
+        while (auto const l = lines.next())
+        {
+          for (auto s(*l);;)
+          {
+            auto const i(s.find(' '));
+
+            g.yield(s.substr(0, i));
+
+            if (std::string_view::npos == i) break; else s.remove_prefix(i + 1);
+          }
+        }
+      }
+    )
+  );
+
+  for (auto const w: words) std::cout << '[' << w << ']';
+  std::cout << std::endl;
+
+  return 0;
+}
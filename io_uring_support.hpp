@@ -0,0 +1,235 @@
+#ifndef CR2_IO_URING_SUPPORT_HPP
+# define CR2_IO_URING_SUPPORT_HPP
+# pragma once
+
+#include <liburing.h>
+
+#include <cerrno>
+#include <chrono>
+#include <system_error>
+#include <utility> // std::exchange
+
+#include "common2.hpp"
+
+namespace cr2
+{
+
+// every thread, that runs a loop, has its own ring; a ring, that run()
+// set up, is torn down, when the thread exits, unless it was torn down and
+// reset before
+static inline thread_local struct io_uring* ring;
+
+namespace detail
+{
+
+// throws std::system_error, if the ring can not be set up
+inline struct io_uring* make_ring()
+{
+  static thread_local struct owner
+  {
+    ~owner()
+    {
+      if (ring)
+      {
+        io_uring_queue_exit(ring);
+        delete std::exchange(ring, {});
+      }
+    }
+  } o;
+
+  auto const r(new struct io_uring);
+
+  if (auto const e(io_uring_queue_init(256, r, 0)); e)
+  {
+    delete r;
+
+    throw std::system_error(-e, std::system_category(),
+      "io_uring_queue_init");
+  }
+
+  return r;
+}
+
+static inline thread_local std::size_t uring_pending; // sqes without a cqe
+
+inline struct io_uring_sqe* get_sqe(unsigned const n = 1) noexcept
+{ // make room for n sqes, that need to be submitted together
+  if (io_uring_sq_space_left(ring) < n)
+  {
+    io_uring_submit(ring);
+  }
+
+  auto const sqe(io_uring_get_sqe(ring));
+  uring_pending += bool(sqe);
+
+  return sqe;
+}
+
+inline auto to_timespec(duration_c auto const d) noexcept
+{
+  return __kernel_timespec{
+    .tv_sec = std::chrono::floor<std::chrono::seconds>(d).count(),
+    .tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      d - std::chrono::floor<std::chrono::seconds>(d)).count()
+  };
+}
+
+}
+
+// sqes are only queued here, run() submits them once per tick
+template <auto G>
+int await(auto& c, auto&& ...a)
+  noexcept(noexcept(c.pause()))
+{
+  int r;
+
+  gnr::forwarder<void(int) noexcept> f(
+    [&](int const res) noexcept
+    {
+      r = res;
+      c.unpause();
+    }
+  );
+
+  if (auto const sqe(detail::get_sqe()); sqe)
+  {
+    G(sqe, std::forward<decltype(a)>(a)...);
+    io_uring_sqe_set_data(sqe, &f);
+
+    c.pause();
+
+    return r;
+  }
+  else
+  {
+    return -EBUSY;
+  }
+}
+
+// the operation is cancelled with -ECANCELED, if d elapses first
+template <auto G>
+int await(auto& c, duration_c auto const d, auto&& ...a)
+  noexcept(noexcept(c.pause()))
+{
+  int r;
+
+  gnr::forwarder<void(int) noexcept> f(
+    [&](int const res) noexcept
+    {
+      r = res;
+      c.unpause();
+    }
+  );
+
+  if (auto const sqe(detail::get_sqe(2)); sqe)
+  {
+    G(sqe, std::forward<decltype(a)>(a)...);
+    io_uring_sqe_set_data(sqe, &f);
+    io_uring_sqe_set_flags(sqe, IOSQE_IO_LINK);
+
+    auto ts(detail::to_timespec(d));
+
+    {
+      auto const tsqe(detail::get_sqe());
+
+      io_uring_prep_link_timeout(tsqe, &ts, 0);
+      io_uring_sqe_set_data(tsqe, {});
+    }
+
+    c.pause();
+
+    return r;
+  }
+  else
+  {
+    return -EBUSY;
+  }
+}
+
+bool await(auto& c, duration_c auto const d)
+  noexcept(noexcept(c.pause()))
+{
+  auto ts(detail::to_timespec(d));
+
+  return -ETIME != await<io_uring_prep_timeout>(c, &ts, 0u, 0u);
+}
+
+// throws std::system_error, if the ring can not be set up, e.g. if
+// io_uring is disabled or filtered by seccomp
+auto run(auto&& ...c)
+  requires(sizeof...(c) >= 1)
+{
+  {
+    auto const r(ring ? ring : ring = detail::make_ring());
+
+    detail::ready_queue q;
+
+    q.attach(c...); // detached, when q goes out of scope
+
+    for (;;)
+    {
+      q();
+
+      if (!q.poll())
+      { // cpu-bound coroutines are ready, the reactor can wait
+        continue;
+      }
+      else if (q || (q.paused() && detail::uring_pending))
+      { // a single syscall submits the sqes queued during the tick
+        if (!q || io_uring_sq_ready(r))
+        {
+          io_uring_submit_and_wait(r, !q);
+        }
+
+        unsigned h, n{};
+        struct io_uring_cqe* cqe;
+
+        io_uring_for_each_cqe(r, h, cqe)
+        {
+          ++n;
+
+          if (auto const f(io_uring_cqe_get_data(cqe)); f)
+          {
+            (*static_cast<gnr::forwarder<void(int)>*>(f))(cqe->res);
+          }
+        }
+
+        io_uring_cq_advance(r, n);
+        detail::uring_pending -= n;
+      }
+      else
+      {
+        break;
+      }
+    }
+  }
+
+  if constexpr(sizeof...(c) > 1)
+  {
+    return std::tuple<decltype(c.template retval<true>())...>{
+      c.template retval<true>()...
+    };
+  }
+  else
+  {
+    return (c, ...).template retval<>();
+  }
+}
+
+auto make_and_run(auto&& ...c)
+  noexcept(noexcept(run(make_plain(std::forward<decltype(c)>(c))...)))
+{
+  return run(make_plain(std::forward<decltype(c)>(c))...);
+}
+
+template <std::size_t ...S>
+auto make_and_run(auto&& ...c)
+  noexcept(noexcept(run(make_plain(std::forward<decltype(c)>(c))...)))
+  requires(sizeof...(S) == sizeof...(c))
+{
+  return run(make_plain<S>(std::forward<decltype(c)>(c))...);
+}
+
+}
+
+#endif // CR2_IO_URING_SUPPORT_HPP
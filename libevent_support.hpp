@@ -6,18 +6,43 @@
 #include <event2/event_struct.h>
 #include <event2/thread.h>
 
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <algorithm> // std::copy_n, std::min
+#include <cerrno>
 #include <chrono>
 #include <concepts>
 #include <iterator>
+#include <span>
 
 #include "generic/invoke.hpp"
 
 #include "common2.hpp"
+#include "timer_wheel.hpp"
 
 namespace cr2
 {
 
-static inline struct event_base* base;
+// every thread, that runs a loop, has its own base; a base, that run()
+// created, is freed, when the thread exits, unless it was freed and reset
+// before, e.g. ahead of libevent_global_shutdown()
+static inline thread_local struct event_base* base;
+
+namespace detail
+{
+
+inline struct event_base* make_base() noexcept
+{
+  static thread_local struct owner
+  {
+    ~owner() { if (base) event_base_free(std::exchange(base, {})); }
+  } o;
+
+  return event_base_new();
+}
+
+}
 
 extern "C"
 {
@@ -35,39 +60,25 @@ inline void timer_cb(evutil_socket_t, short, void* const arg) noexcept
 
 }
 
-template <class D>
-concept duration_c = requires(D d)
-  {
-    []<class A, class B>(std::chrono::duration<A, B>){}(d);
-  };
-
 template <typename T>
 concept event_c = std::is_base_of_v<struct event, std::remove_pointer_t<T>>;
 
 template <typename T>
 concept integral_c = std::integral<std::remove_cvref_t<T>>;
 
-//
-auto await(auto& c, duration_c auto const d)
+template <typename T>
+concept iovec_c = std::is_same_v<struct iovec, std::remove_cvref_t<T>>;
+
+// sleeps are kept in the timer wheel, not in the min-heap of the base
+bool await(auto& c, duration_c auto const d)
   noexcept(noexcept(c.pause()))
 {
-  gnr::forwarder<void() noexcept> f(
-    [&]() noexcept
-    {
-      c.unpause();
-    }
-  );
+  timer_wheel::timer t([&]() noexcept { c.unpause(); });
 
-  struct event ev;
-  evtimer_assign(&ev, base, timer_cb, &f);
+  timers.add(t, d);
+  c.pause();
 
-  struct timeval tv{
-    .tv_sec = std::chrono::floor<std::chrono::seconds>(d).count(),
-    .tv_usec = std::chrono::duration_cast<std::chrono::microseconds>(
-      d - std::chrono::floor<std::chrono::seconds>(d)).count()
-  };
-
-  return -1 == event_add(&ev, &tv) ? true : (c.pause(), false);
+  return false;
 }
 
 auto await(auto& c, integral_c auto&& ...a)
@@ -166,20 +177,29 @@ auto await(auto& c, duration_c auto const d,
     }
   );
 
-  struct timeval tv{
-    .tv_sec = std::chrono::floor<std::chrono::seconds>(d).count(),
-    .tv_usec = std::chrono::duration_cast<std::chrono::microseconds>(
-      d - std::chrono::floor<std::chrono::seconds>(d)).count()
-  };
+  timer_wheel::timer tm(
+    [&]() noexcept
+    {
+      [&]<auto ...I>(std::index_sequence<I...>) noexcept
+      { // unless a socket became ready during the same loop iteration
+        if (!(std::get<2 * I>(t) || ...))
+        {
+          ((std::get<2 * I>(t) = EV_TIMEOUT), ...);
+        }
+      }(std::make_index_sequence<sizeof...(a) / 2>());
+
+      c.unpause();
+    }
+  );
 
   struct event ev[sizeof...(a) / 2];
 
   if (gnr::invoke_split_cond<2>(
-      [ep(&*ev), &f, &tv](auto&& flags, auto&& fd) mutable noexcept
+      [ep(&*ev), &f](auto&& flags, auto&& fd) mutable noexcept
       {
         event_assign(ep, base, fd, EV_PERSIST|flags, socket_cb, &f);
 
-        return -1 == event_add(ep++, &tv);
+        return -1 == event_add(ep++, {});
       },
       std::forward<decltype(a)>(a)...
     )
@@ -197,6 +217,7 @@ auto await(auto& c, duration_c auto const d,
   }
   else
   {
+    timers.add(tm, d);
     c.pause();
 
     std::for_each(
@@ -209,6 +230,240 @@ auto await(auto& c, duration_c auto const d,
   return t;
 }
 
+// an fd, that is registered with the base once, edge-triggered, and stays
+// armed across awaits; edges, that arrive while nobody waits, are latched;
+// must be constructed after the base exists, e.g. within a coroutine; at
+// most one coroutine may wait per direction, a second waiter would replace
+// the first, which then never resumes, fd_writer serializes several writers
+class fd_event
+{
+  struct event ev_;
+
+  gnr::forwarder<void(short) noexcept>* r_{}, *w_{};
+  short ready_{};
+
+  bool added_;
+
+  gnr::forwarder<void(evutil_socket_t, short) noexcept> g_{
+    [this](evutil_socket_t, short const f) noexcept
+    {
+      ready_ |= f;
+
+      auto const wake([&](auto const w, short const m) noexcept
+        {
+          if (w && (ready_ & m))
+          {
+            if (w == r_) r_ = {};
+            if (w == w_) w_ = {};
+
+            (*w)(ready_);
+          }
+        }
+      );
+
+      wake(r_, EV_READ | EV_CLOSED);
+      wake(w_, EV_WRITE | EV_CLOSED);
+    }
+  };
+
+public:
+  explicit fd_event(evutil_socket_t const fd,
+    short const f = EV_READ | EV_WRITE | EV_CLOSED) noexcept
+  {
+    event_assign(&ev_, base, fd, EV_PERSIST | EV_ET | f, socket_cb, &g_);
+    added_ = -1 != event_add(&ev_, {});
+  }
+
+  ~fd_event() { event_del(&ev_); }
+
+  fd_event(fd_event const&) = delete;
+
+  //
+  fd_event& operator=(fd_event const&) = delete;
+
+  //
+  explicit operator bool() const noexcept { return added_; }
+
+  //
+  evutil_socket_t fd() const noexcept { return event_get_fd(&ev_); }
+
+  //
+  short wait(auto& c, short f)
+    noexcept(noexcept(c.pause()))
+  {
+    f |= EV_CLOSED;
+
+    if (auto const m(ready_ & f); m)
+    { // consume the latched edge
+      ready_ &= ~(m & (EV_READ | EV_WRITE));
+
+      return m;
+    }
+    else
+    {
+      short r{};
+
+      gnr::forwarder<void(short) noexcept> g(
+        [&](short const e) noexcept
+        {
+          r = e & f;
+          c.unpause();
+        }
+      );
+
+      if (EV_READ & f) r_ = &g;
+      if (EV_WRITE & f) w_ = &g;
+
+      c.pause();
+
+      if (&g == r_) r_ = {};
+      if (&g == w_) w_ = {};
+
+      ready_ &= ~(r & (EV_READ | EV_WRITE));
+
+      return r;
+    }
+  }
+};
+
+// returns the ready flags, the await costs no syscalls
+short await(auto& c, fd_event& e, short const f)
+  noexcept(noexcept(c.pause()))
+{
+  return e ? e.wait(c, f) : short(EV_CLOSED);
+}
+
+// returns the ready flags, 0 on timeout
+short await(auto& c, duration_c auto const d, fd_event& e, short const f)
+  noexcept(noexcept(c.pause()))
+{
+  if (e)
+  {
+    timer_wheel::timer t([&]() noexcept { c.unpause(); });
+
+    timers.add(t, d);
+
+    return e.wait(c, f);
+  }
+  else
+  {
+    return EV_CLOSED;
+  }
+}
+
+namespace detail
+{
+
+// the buffers, that remain to be written, the first one from o on
+struct iov_cursor
+{
+  struct iovec const* p;
+  std::size_t n, o{};
+
+  // skips the written and empty buffers
+  bool done() noexcept
+  {
+    for (; n && (o == p->iov_len); ++p, --n, o = {});
+
+    return !n;
+  }
+
+  std::size_t gather(struct iovec* const d, std::size_t k) const noexcept
+  {
+    if ((k = std::min(k, n)))
+    {
+      std::copy_n(p, k, d);
+
+      d->iov_base = static_cast<char*>(d->iov_base) + o;
+      d->iov_len -= o;
+    }
+
+    return k;
+  }
+
+  // returns what is left of s, once all buffers are written
+  std::size_t advance(std::size_t s) noexcept
+  {
+    for (; s && n; ++p, --n, o = {})
+    {
+      if (auto const l(p->iov_len - o); s < l)
+      {
+        o += s;
+
+        return {};
+      }
+      else
+      {
+        s -= l;
+      }
+    }
+
+    return s;
+  }
+};
+
+// sendmsg() does not raise SIGPIPE, writev() also works for pipes
+inline ssize_t writev(int const fd, struct iovec* const v,
+  std::size_t const n) noexcept
+{
+  struct msghdr m{};
+  m.msg_iov = v;
+  m.msg_iovlen = n;
+
+  if (auto const r(sendmsg(fd, &m, MSG_NOSIGNAL));
+    (-1 != r) || (ENOTSOCK != errno))
+  {
+    return r;
+  }
+  else
+  {
+    return ::writev(fd, v, n);
+  }
+}
+
+}
+
+// writes all buffers, awaiting EV_WRITE on partial writes; returns the
+// number of bytes written, or -1 with errno set
+ssize_t write_all(auto& c, fd_event& e, std::span<struct iovec const> const v)
+{
+  ssize_t t{};
+
+  for (detail::iov_cursor i{v.data(), v.size()}; !i.done();)
+  {
+    struct iovec iov[64];
+
+    if (auto const sz(detail::writev(e.fd(), iov,
+      i.gather(iov, std::size(iov)))); -1 != sz)
+    {
+      t += sz;
+      i.advance(sz);
+    }
+    else if (EINTR == errno)
+    {
+      continue;
+    }
+    else if ((EAGAIN == errno) || (EWOULDBLOCK == errno))
+    {
+      await(c, e, EV_WRITE);
+    }
+    else
+    {
+      return -1;
+    }
+  }
+
+  return t;
+}
+
+ssize_t write_all(auto& c, fd_event& e, iovec_c auto const& ...v)
+  requires(bool(sizeof...(v)))
+{
+  struct iovec const iov[]{v...};
+
+  return write_all(c, e, std::span(iov));
+}
+
 bool await(auto& c, event_c auto* ...ev)
   noexcept(noexcept(c.pause()))
   requires(bool(sizeof...(ev)))
@@ -263,24 +518,40 @@ auto run(auto&& ...c)
   requires(sizeof...(c) >= 1)
 {
   {
-    auto const b(base ? base : base = event_base_new());
+    auto const b(base ? base : base = detail::make_base());
 
-    for (bool p, s;;)
-    {
-      p = s = {};
+    // a single libevent timer wakes the loop for the timer wheel
+    gnr::forwarder<void() noexcept> f([]() noexcept {});
 
-      (
-        (
-          (c.state() >= NEW ? c() : void()),
-          (p = p || (PAUSED == c.state())),
-          (s = s || (SUSPENDED == c.state()))
-        ),
-        ...
-      );
+    struct event te;
+    evtimer_assign(&te, b, timer_cb, &f);
+    SCOPE_EXIT(&, evtimer_del(&te));
+
+    detail::ready_queue q;
+
+    q.attach(c...); // detached, when q goes out of scope
+
+    for (;;)
+    {
+      q();
 
-      if (p || s)
+      if (!q.poll())
+      { // cpu-bound coroutines are ready, the reactor can wait
+        continue;
+      }
+      else if (q || q.paused())
       {
-        event_base_loop(b, s ? EVLOOP_NONBLOCK : EVLOOP_ONCE);
+        if (!q && timers)
+        {
+          auto const ms(timers.timeout());
+
+          struct timeval tv{.tv_sec = ms / 1000, .tv_usec = ms % 1000 * 1000};
+          evtimer_add(&te, &tv);
+        }
+
+        event_base_loop(b, q ? EVLOOP_NONBLOCK : EVLOOP_ONCE);
+
+        if (timers) timers.advance();
       }
       else
       {
@@ -2,30 +2,53 @@
 # define CR2_LIBNONE_SUPPORT_HPP
 # pragma once
 
+#include <thread>
+
 #include "common2.hpp"
+#include "timer_wheel.hpp"
 
 namespace cr2
 {
 
+bool await(auto& c, duration_c auto const d)
+  noexcept(noexcept(c.pause()))
+{
+  timer_wheel::timer t([&]() noexcept { c.unpause(); });
+
+  timers.add(t, d);
+  c.pause();
+
+  return false;
+}
+
 auto run(auto&& ...c)
   noexcept(noexcept((c.template retval<>(), ...)))
   requires(sizeof...(c) >= 1)
 {
   {
-    bool s;
+    detail::ready_queue q;
+
+    q.attach(c...); // detached, when q goes out of scope
 
-    do
+    for (;;)
     {
-      s = {};
-
-      (
-        (
-          (c.state() >= NEW ? c() : void()),
-          (s = s || (SUSPENDED == c.state()))
-        ),
-        ...
-      );
-    } while (s);
+      q();
+
+      if (timers)
+      { // there is nothing else to wait for
+        if (!q)
+        {
+          std::this_thread::sleep_for(
+            std::chrono::milliseconds(timers.timeout()));
+        }
+
+        timers.advance();
+      }
+      else if (!q)
+      {
+        break;
+      }
+    }
   }
 
   if constexpr(sizeof...(c) > 1)
@@ -0,0 +1,214 @@
+#ifndef CR2_LIBUV_FILE_HPP
+# define CR2_LIBUV_FILE_HPP
+# pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <type_traits>
+
+#include "libuv_support.hpp"
+
+namespace cr2
+{
+
+// vectored reads and writes from/into any contiguous range of uv_buf_t,
+// e.g. an array, a vector or a span; returns the number of bytes
+// transferred or an error, off < 0 means the current file position
+template <auto G>
+auto await(auto& c, uv_fs_t* const uvfs, auto const f,
+  std::ranges::contiguous_range auto&& b, auto const off)
+  noexcept(noexcept(c.pause()))
+  requires(((G == uv_fs_read) || (G == uv_fs_write)) &&
+    std::is_same_v<uv_buf_t,
+      std::remove_cv_t<std::ranges::range_value_t<decltype(b)>>>)
+{
+  return await<G>(c, uvfs, uv_file(f), std::ranges::data(b),
+    unsigned(std::ranges::size(b)), std::int64_t(off));
+}
+
+// streams a file in chunks of B bytes, keeping N reads in flight ahead of
+// the consumer; chunks are returned in file order and stay valid until the
+// next call of next(); a short read ends the stream, as regular files only
+// return short reads at their end; close() must be awaited, before the
+// reader is destroyed
+template <std::size_t N = 4, std::size_t B = 64 * 1024>
+class uv_reader
+{
+  static_assert(N && B);
+
+private:
+  enum { IDLE, BUSY, DONE };
+
+  struct slot
+  {
+    uv_reader* r;
+
+    uv_fs_t req;
+    int state{IDLE};
+
+    gnr::forwarder<void() noexcept> f{
+      [this]() noexcept
+      {
+        state = DONE;
+
+        if (auto const w(r->w_); w && (!r->want_ || (this == r->want_)))
+        {
+          r->w_ = {};
+
+          (*w)();
+        }
+      }
+    };
+  };
+
+  // the buffers would not fit onto a coroutine stack
+  std::unique_ptr<char[]> const b_{new char[N * B]};
+
+  slot s_[N];
+
+  gnr::forwarder<void() noexcept>* w_{};
+  slot* want_{};
+
+  uv_file const f_;
+  std::int64_t off_; // offset of the next submitted read
+
+  std::size_t h_{}; // slot of the next chunk
+  ssize_t error_{};
+
+  bool eof_{}, taken_{};
+
+  void submit(std::size_t const i) noexcept
+  {
+    auto& s(s_[i]);
+
+    auto const buf(uv_buf_init(&b_[i * B], B));
+
+    s.req.data = &s.f;
+
+    if (auto const e(uv_fs_read(loop, &s.req, f_, &buf, 1, off_, uv_fs_cb));
+      e < 0)
+    {
+      s.req.result = e;
+      s.state = DONE;
+    }
+    else
+    {
+      s.state = BUSY;
+    }
+
+    off_ += B;
+  }
+
+  void release(std::size_t const i) noexcept
+  {
+    uv_fs_req_cleanup(&s_[i].req);
+    s_[i].state = IDLE;
+
+    if (!eof_) submit(i);
+  }
+
+  void wait(auto& c, slot* const s)
+    noexcept(noexcept(c.pause()))
+  {
+    gnr::forwarder<void() noexcept> g([&]() noexcept { c.unpause(); });
+
+    w_ = &g;
+    want_ = s;
+
+    c.pause();
+  }
+
+public:
+  explicit uv_reader(uv_file const f, std::int64_t const off = {}) noexcept:
+    f_(f),
+    off_(off)
+  {
+    for (std::size_t i{}; N != i; ++i)
+    {
+      s_[i].r = this;
+      submit(i);
+    }
+  }
+
+  uv_reader(uv_reader const&) = delete;
+
+  //
+  uv_reader& operator=(uv_reader const&) = delete;
+
+  //
+  explicit operator bool() const noexcept { return !eof_; }
+
+  // the error, that ended the stream, if any
+  auto error() const noexcept { return error_; }
+
+  // the next chunk, an empty span at the end of the stream or on error
+  std::span<char const> next(auto& c)
+    noexcept(noexcept(c.pause()))
+  {
+    if (taken_)
+    {
+      taken_ = false;
+
+      release(h_);
+      h_ = (h_ + 1) % N;
+    }
+
+    if (eof_)
+    {
+      return {};
+    }
+    else
+    {
+      auto& s(s_[h_]);
+
+      while (BUSY == s.state) wait(c, &s);
+
+      taken_ = true;
+
+      if (auto const r(s.req.result); r < ssize_t(B))
+      {
+        eof_ = true;
+
+        if (r < 0)
+        {
+          error_ = r;
+
+          return {};
+        }
+      }
+
+      return {&b_[h_ * B], std::size_t(s.req.result)};
+    }
+  }
+
+  // cancels the reads in flight and waits for them
+  void close(auto& c)
+    noexcept(noexcept(c.pause()))
+  {
+    eof_ = true;
+
+    for (auto& s: s_)
+    {
+      if (BUSY == s.state) uv_cancel(reinterpret_cast<uv_req_t*>(&s.req));
+    }
+
+    for (auto& s: s_)
+    {
+      while (BUSY == s.state) wait(c, {});
+
+      if (DONE == s.state)
+      {
+        uv_fs_req_cleanup(&s.req);
+        s.state = IDLE;
+      }
+    }
+
+    taken_ = false;
+  }
+};
+
+}
+
+#endif // CR2_LIBUV_FILE_HPP
@@ -4,21 +4,37 @@
 
 #include <uv.h>
 
+#include <atomic>
+#include <span>
+
 #include "common2.hpp"
+#include "timer_wheel.hpp"
 
 namespace cr2
 {
 
+// every thread, that runs a loop, has its own, set by run(), if not set
+// before; the first one is the default loop, the others are closed, when
+// their threads exit
+static inline thread_local uv_loop_t* loop;
+
 extern "C"
 {
 
+// reads go straight into the buffer of the waiting coroutine, without one
+// libuv gets no buffer, see uv_read_cb()
 inline void uv_alloc_cb(uv_handle_t* const uvh, std::size_t,
   uv_buf_t* const buf) noexcept
 {
-  auto const p(static_cast<std::pair<void*, char*>*>(uvh->data));
-
-  buf->base = std::get<1>(*p);
-  buf->len = 65536;
+  if (auto const p(static_cast<std::pair<void*, std::span<char>>*>(
+    uvh->data)); p)
+  {
+    *buf = uv_buf_init(std::get<1>(*p).data(), std::get<1>(*p).size());
+  }
+  else
+  {
+    *buf = uv_buf_init(nullptr, 0);
+  }
 }
 
 inline void uv_close_cb(uv_handle_t* const uvh) noexcept
@@ -26,6 +42,15 @@ inline void uv_close_cb(uv_handle_t* const uvh) noexcept
   (*static_cast<gnr::forwarder<void()>*>(uvh->data))();
 }
 
+inline void uv_wake_cb(uv_timer_t*) noexcept
+{ // the loop only needs to wake up, run() advances the timer wheel
+}
+
+inline void uv_walk_close_cb(uv_handle_t* const uvh, void*) noexcept
+{
+  if (!uv_is_closing(uvh)) uv_close(uvh, {});
+}
+
 inline void uv_connect_cb(uv_connect_t* const uvc, int const status) noexcept
 {
   (*static_cast<gnr::forwarder<void(int)>*>(uvc->data))(status);
@@ -37,14 +62,67 @@ inline void uv_fs_cb(uv_fs_t* const uvfs) noexcept
 }
 
 inline void uv_read_cb(uv_stream_t* const uvs,
-  ssize_t const sz, uv_buf_t const* const buf) noexcept
+  ssize_t const sz, uv_buf_t const*) noexcept
+{
+  if (auto const p(static_cast<std::pair<void*, std::span<char>>*>(
+    uvs->data)); !p)
+  { // nobody waits, stop polling, until the next await
+    uv_read_stop(uvs);
+  }
+  else if (sz)
+  {
+    (*static_cast<gnr::forwarder<void(ssize_t) noexcept>*>(
+      std::get<0>(*p)))(sz);
+  }
+}
+
+}
+
+namespace detail
 {
-  auto const p(static_cast<std::pair<void*, char*>*>(uvs->data));
 
-  (*static_cast<gnr::forwarder<void(ssize_t, uv_buf_t const*)>*>(
-    std::get<0>(*p)))(sz, buf);
+inline uv_loop_t* make_loop() noexcept
+{
+  static constinit std::atomic_flag f;
+
+  if (f.test_and_set(std::memory_order_relaxed))
+  { // closed, together with the handles left open, when the thread exits
+    static thread_local struct owner
+    {
+      uv_loop_t l;
+
+      owner() noexcept { uv_loop_init(&l); }
+
+      ~owner()
+      {
+        uv_walk(&l, uv_walk_close_cb, {});
+        uv_run(&l, UV_RUN_DEFAULT);
+        uv_loop_close(&l);
+
+        if (&l == loop) loop = {};
+      }
+    } o;
+
+    return &o.l;
+  }
+  else
+  {
+    return uv_default_loop();
+  }
+}
+
 }
 
+// sleeps are kept in the timer wheel, not in the timers of the loop
+bool await(auto& c, duration_c auto const d)
+  noexcept(noexcept(c.pause()))
+{
+  timer_wheel::timer t([&]() noexcept { c.unpause(); });
+
+  timers.add(t, d);
+  c.pause();
+
+  return false;
 }
 
 template <auto G>
@@ -85,7 +163,7 @@ auto await(auto& c, uv_fs_t* const uvfs, auto&& ...a)
 
   uvfs->data = &g;
 
-  if (auto const r(G(uv_default_loop(),
+  if (auto const r(G(loop,
       uvfs,
       std::forward<decltype(a)>(a)...,
       uv_fs_cb
@@ -116,63 +194,85 @@ auto await(auto& c, uv_handle_t* const uvh)
   c.pause();
 }
 
+// reads into b, returns the number of bytes read or an error, reading stays
+// started between awaits, unless b filled up and more data was pending
 template <auto G>
-auto await(auto& c, uv_stream_t* const uvs, char* const data)
+ssize_t await(auto& c, uv_stream_t* const uvs, std::span<char> const b)
   noexcept(noexcept(c.pause()))
   requires(G == uv_read_start)
 {
-  ssize_t s;
-  uv_buf_t const* b;
+  ssize_t r;
 
-  gnr::forwarder<void(ssize_t, uv_buf_t const*) noexcept> g(
-    [&](auto const sz, auto const buf) noexcept
+  gnr::forwarder<void(ssize_t) noexcept> g(
+    [&](auto const sz) noexcept
     {
-      s = sz;
-      b = buf;
+      r = sz;
+      uvs->data = {};
 
       c.unpause();
     }
   );
 
-  std::pair<void*, char*> p(&g, data);
+  std::pair<void*, std::span<char>> p(&g, b);
 
   uvs->data = &p;
 
-  if (s = G(uvs, uv_alloc_cb, uv_read_cb); s < 0)
+  if (auto const e(G(uvs, uv_alloc_cb, uv_read_cb)); (e < 0) &&
+    (UV_EALREADY != e))
   {
-    return std::pair{s, decltype(b){}};
+    uvs->data = {};
+
+    return e;
   }
 
   c.pause();
 
-  return std::pair{s, b};
+  return r;
 }
 
 auto run(auto&& ...c)
   noexcept(noexcept((c.template retval<>(), ...)))
   requires(sizeof...(c) >= 1)
 {
-  for (bool p, s;;)
   {
-    p = s = {};
-
-    (
-      (
-        (c.state() >= NEW ? c() : void()),
-        (p = p || (PAUSED == c.state())),
-        (s = s || (SUSPENDED == c.state()))
-      ),
-      ...
-    );
-
-    if (p || s)
-    {
-      uv_run(uv_default_loop(), s ? UV_RUN_NOWAIT : UV_RUN_ONCE);
-    }
-    else
+    auto const l(loop ? loop : loop = detail::make_loop());
+
+    // a single libuv timer wakes the loop for the timer wheel
+    uv_timer_t te;
+    uv_timer_init(l, &te);
+
+    detail::ready_queue q;
+
+    q.attach(c...); // detached, when q goes out of scope
+
+    for (;;)
     {
-      break;
+      q();
+
+      if (!q.poll())
+      { // cpu-bound coroutines are ready, the reactor can wait
+        continue;
+      }
+      else if (q || q.paused())
+      {
+        if (!q && timers)
+        {
+          uv_timer_start(&te, uv_wake_cb, timers.timeout(), 0);
+        }
+
+        uv_run(l, q ? UV_RUN_NOWAIT : UV_RUN_ONCE);
+
+        if (timers) timers.advance();
+      }
+      else
+      {
+        break;
+      }
     }
+
+    // te is released by the close phase of the loop
+    uv_close(reinterpret_cast<uv_handle_t*>(&te), {});
+    uv_run(l, UV_RUN_NOWAIT);
   }
 
   if constexpr(sizeof...(c) > 1)
@@ -7,18 +7,43 @@
 #include "boost/context/fiber.hpp"
 
 #include "common.hpp"
+#include "ready_queue.hpp"
+#include "stack.hpp"
 
 namespace cr2
 {
 
-template <typename F, typename R, std::size_t S>
-class coroutine
+template <typename F, typename R, std::size_t S,
+  template <std::size_t> class A = heap_stack>
+class coroutine: detail::ready_node
 {
-  template <typename, typename, std::size_t>
+  template <typename, typename, std::size_t, template <std::size_t> class>
   friend class coroutine;
 
+  friend class detail::ready_queue;
+
 private:
+  struct stack_allocator
+  {
+    void* const sp_;
+
+    auto allocate() const noexcept
+    {
+      boost::context::stack_context sc;
+
+      sc.size = S;
+      sc.sp = sp_;
+
+      return sc;
+    }
+
+    void deallocate(boost::context::stack_context&) const noexcept { }
+  };
+
+  A<S> stack_;
+
   boost::context::fiber fi_;
+  boost::context::fiber** sink_, *from_{};
 
   enum state state_;
 
@@ -57,13 +82,31 @@ private:
   template <enum state State>
   void suspend()
   {
+    if constexpr(SUSPENDED == State) enqueue(); else park();
+
     state_ = State;
-    fi_ = std::move(fi_).resume();
+    resumed(std::move(fi_).resume());
+  }
+
+  void resumed(boost::context::fiber&& fi) noexcept
+  { // a coroutine, that transferred to us, left our way out in from_
+    if (from_)
+    {
+      fi_ = std::move(*from_);
+      *std::exchange(from_, {}) = std::move(fi);
+    }
+    else
+    {
+      fi_ = std::move(fi);
+    }
   }
 
 public:
   explicit coroutine(F&& f)
-    noexcept(noexcept(F(std::move(f)))):
+    noexcept(
+      noexcept(F(std::move(f))) &&
+      std::is_nothrow_default_constructible_v<A<S>>
+    ):
     state_{NEW},
     f_(std::move(f))
   {
@@ -90,7 +133,11 @@ public:
   coroutine(coroutine const&) = delete;
 
   coroutine(coroutine&& o)
-    noexcept(noexcept(F(std::move(o.f_))) && noexcept(o.destroy())):
+    noexcept(
+      noexcept(F(std::move(o.f_))) &&
+      noexcept(o.destroy()) &&
+      std::is_nothrow_default_constructible_v<A<S>>
+    ):
     state_{NEW},
     f_(std::move(o.f_))
   {
@@ -115,7 +162,13 @@ public:
     }
 
     state_ = RUNNING;
-    fi_ = std::move(fi_).resume();
+
+    // suspend_to() redirects s to the coroutine, that takes over
+    auto s(&fi_);
+    sink_ = &s;
+
+    auto fi(std::move(fi_).resume());
+    *s = std::move(fi);
   }
 
   //
@@ -154,9 +207,18 @@ public:
 
   auto state() const noexcept { return state_; }
 
+#if defined(CR2_STACK_WATERMARK)
+  auto max_stack_used() const noexcept { return stack_.used(); }
+#endif
+
   //
   void pause() { suspend<PAUSED>(); }
-  void unpause() noexcept { state_ = SUSPENDED; }
+  void unpause() noexcept
+  {
+    if (PAUSED == state_) unpark();
+
+    state_ = SUSPENDED;
+  }
 
   void reset()
   {
@@ -169,12 +231,14 @@ public:
       destroy();
     }
 
+    fi_ = {}; // the old fiber lives on the same stack
+
     fi_ = {
       std::allocator_arg_t{},
-      boost::context::fixedsize_stack(S),
+      stack_allocator{stack_.top()},
       [&](auto&& fi)
       {
-        fi_ = std::move(fi);
+        resumed(std::move(fi));
 
         if constexpr(std::is_same_v<detail::empty_t, R>)
         {
@@ -199,15 +263,28 @@ public:
       }
     };
 
+    drop();
     state_ = NEW;
   }
 
   void suspend() { return suspend<SUSPENDED>(); }
 
-  template <typename A, typename B, std::size_t C>
-  void suspend_to(coroutine<A, B, C>& c)
+  // symmetric transfer, c takes over our way out and we are suspended
+  template <typename G, typename Q, std::size_t T,
+    template <std::size_t> class B>
+  void suspend_to(coroutine<G, Q, T, B>& c)
   {
-    c(); suspend();
+    enqueue();
+    state_ = SUSPENDED;
+
+    if (SUSPENDED != c.state()) c.reset();
+
+    c.state_ = RUNNING;
+
+    *(c.sink_ = sink_) = &c.fi_;
+    c.from_ = &fi_;
+
+    resumed(std::move(c.fi_).resume());
   }
 };
 
@@ -0,0 +1,321 @@
+#ifndef CR2_READY_QUEUE_HPP
+# define CR2_READY_QUEUE_HPP
+# pragma once
+
+#include <chrono>
+#include <type_traits> // std::remove_cvref_t
+#include <utility> // std::exchange
+
+#include "common.hpp"
+
+#if defined(CR2_TRACE)
+# include "trace.hpp"
+#endif
+
+namespace cr2
+{
+
+// while coroutines are ready, the run loops poll their reactor only every
+// ticks ticks, or once budget has passed since the last poll, whichever
+// comes first; ticks = 1 polls on every tick, larger values favour
+// cpu-bound coroutines over i/o latency, a zero budget saves reading the
+// clock every tick
+static inline struct
+{
+  unsigned ticks{64};
+  std::chrono::microseconds budget{1000};
+} poll_policy;
+
+}
+
+namespace cr2::detail
+{
+
+class ready_queue;
+
+class ready_node
+{
+  friend class ready_queue;
+
+private:
+  ready_node* next_;
+  ready_node* aprev_, *anext_; // the nodes attached to q_
+  ready_queue* q_{};
+
+  void (*invoke_)(ready_node*);
+
+  bool queued_{}, parked_{};
+
+#if defined(CR2_TRACE)
+  trace::detail::node tn_{};
+#endif
+
+protected:
+  ready_node() = default;
+  inline ~ready_node();
+
+  ready_node(ready_node const&) = delete;
+  ready_node& operator=(ready_node const&) = delete;
+
+  // the coroutine calls these on its state transitions
+  inline void enqueue() noexcept; // -> SUSPENDED
+  inline void park() noexcept; // -> PAUSED
+  inline void unpark() noexcept; // PAUSED -> SUSPENDED
+  inline void drop() noexcept; // -> NEW, a pause is abandoned
+};
+
+class ready_queue
+{
+  friend class ready_node;
+
+private:
+  ready_node* head_{}, *tail_{};
+  ready_node* batch_{}; // the rest of the tick, that is running
+  ready_node* attached_{};
+
+  std::size_t paused_{};
+
+  unsigned ticks_{};
+  std::chrono::steady_clock::time_point polled_{
+    std::chrono::steady_clock::now()
+  };
+
+  void push(ready_node* const n) noexcept
+  {
+    if (!n->queued_)
+    {
+      n->next_ = {};
+      n->queued_ = true;
+
+      tail_ ? void(tail_->next_ = n) : void(head_ = n);
+      tail_ = n;
+    }
+  }
+
+  void link(ready_node* const n) noexcept
+  {
+    n->q_ = this;
+    n->aprev_ = {};
+
+    if ((n->anext_ = attached_)) attached_->aprev_ = n;
+    attached_ = n;
+  }
+
+  // n is gone, its pause is no longer waited for
+  void unlink(ready_node* const n) noexcept
+  {
+    if (n->queued_)
+    { // n is either in the running batch, or queued for the next tick
+      ready_node* p{};
+      auto i(batch_);
+
+      for (; i && (n != i); p = i, i = i->next_);
+
+      if (i)
+      {
+        (p ? p->next_ : batch_) = n->next_;
+      }
+      else
+      {
+        p = {};
+
+        for (i = head_; n != i; p = i, i = i->next_);
+
+        (p ? p->next_ : head_) = n->next_;
+        if (n == tail_) tail_ = p;
+      }
+    }
+
+    if (n->parked_) --paused_;
+
+    (n->aprev_ ? n->aprev_->anext_ : attached_) = n->anext_;
+    if (n->anext_) n->anext_->aprev_ = n->aprev_;
+
+    n->q_ = {};
+    n->queued_ = n->parked_ = false;
+  }
+
+public:
+  ready_queue() = default;
+
+  ~ready_queue() { detach(); }
+
+  ready_queue(ready_queue const&) = delete;
+  ready_queue& operator=(ready_queue const&) = delete;
+
+  //
+  explicit operator bool() const noexcept { return head_; }
+
+  void operator()()
+  { // run the coroutines, that were ready at the start of this tick; the
+    // batch is a member, a coroutine may destroy others, that are in it
+    batch_ = std::exchange(head_, {});
+    tail_ = {};
+
+    while (batch_)
+    {
+      auto const n(batch_);
+      batch_ = n->next_;
+
+      n->queued_ = false;
+      n->invoke_(n);
+    }
+  }
+
+  //
+  auto paused() const noexcept { return paused_; }
+
+  // the queue, that c is attached to, if any
+  static ready_queue* of(auto& c) noexcept
+  {
+    return static_cast<ready_node&>(c).q_;
+  }
+
+  // should the run loop poll its reactor after this tick?
+  bool poll() noexcept
+  {
+    using clock = std::chrono::steady_clock;
+
+    auto const b(poll_policy.budget.count());
+
+    if (!head_ || (++ticks_ >= poll_policy.ticks))
+    {
+      ticks_ = {};
+      if (b) polled_ = clock::now();
+
+      return true;
+    }
+    else if (b)
+    {
+      if (auto const now(clock::now()); now - polled_ >= poll_policy.budget)
+      {
+        ticks_ = {};
+        polled_ = now;
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void attach(auto& ...c) noexcept
+  {
+    (
+      [&](auto& c) noexcept
+      {
+        using C = std::remove_cvref_t<decltype(c)>;
+
+        auto& n(static_cast<ready_node&>(c));
+
+        if (this != n.q_)
+        {
+          if (n.q_) n.q_->unlink(&n);
+
+          link(&n);
+        }
+
+        n.invoke_ = [](ready_node* const n)
+          {
+            if (auto& c(static_cast<C&>(*n)); c.state() >= NEW)
+            {
+#if defined(CR2_TRACE)
+              trace::detail::resume(n->tn_, c.id(), c);
+#else
+              c();
+#endif
+            }
+          };
+
+#if defined(CR2_TRACE)
+        trace::detail::attach(n.tn_, c.id());
+#endif
+
+        if (auto const s(c.state()); s >= NEW)
+        {
+          push(&n);
+        }
+        else if ((PAUSED == s) && !n.parked_)
+        {
+          n.parked_ = true;
+          ++paused_;
+        }
+      }(c),
+      ...
+    );
+  }
+
+  // every attached coroutine, spawned ones included
+  void detach() noexcept
+  {
+    while (attached_) unlink(attached_);
+  }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+inline ready_node::~ready_node()
+{
+  if (q_) q_->unlink(this);
+}
+
+inline void ready_node::enqueue() noexcept
+{
+  if (q_) q_->push(this);
+}
+
+inline void ready_node::park() noexcept
+{
+  if (q_ && !parked_)
+  {
+    parked_ = true;
+    ++q_->paused_;
+  }
+}
+
+inline void ready_node::unpark() noexcept
+{
+  if (q_)
+  {
+#if defined(CR2_TRACE)
+    trace::detail::unpark(tn_);
+#endif
+
+    drop();
+    q_->push(this);
+  }
+}
+
+inline void ready_node::drop() noexcept
+{
+  if (parked_)
+  {
+    parked_ = false;
+    --q_->paused_;
+  }
+}
+
+}
+
+namespace cr2
+{
+
+// n is run by the loop, that runs c, from the next tick on; the loop does
+// not own n, n is detached, when it is destroyed, or when the loop returns;
+// returns false, if no loop runs c
+bool spawn(auto& c, auto& n) noexcept
+{
+  if (auto const q(detail::ready_queue::of(c)); q)
+  {
+    q->attach(n);
+
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+}
+
+#endif // CR2_READY_QUEUE_HPP
@@ -0,0 +1,206 @@
+#ifndef CR2_REMOTE_HPP
+# define CR2_REMOTE_HPP
+# pragma once
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <utility> // std::exchange
+
+#include "libevent_support.hpp"
+
+namespace cr2
+{
+
+class remote_handle;
+
+namespace detail
+{
+
+// the wakeups of the handles of a thread, any thread pushes them onto a
+// lock-free stack, the loop of the owning thread drains it; only a push
+// onto the empty stack writes the eventfd, so a burst of wakeups costs a
+// single write and a single loop wakeup; the eventfd is registered with
+// the base, while handles exist
+class mailbox
+{
+  friend class cr2::remote_handle;
+
+private:
+  std::atomic<remote_handle*> head_{};
+
+  int const efd_{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+
+  struct event ev_;
+  std::size_t handles_{};
+
+  gnr::forwarder<void(evutil_socket_t, short) noexcept> g_{
+    [this](evutil_socket_t, short) noexcept { drain(); }
+  };
+
+  inline void drain() noexcept;
+
+  void acquire() noexcept
+  {
+    if ((-1 != efd_) && !handles_++)
+    {
+      event_assign(&ev_, base, efd_, EV_READ | EV_PERSIST, socket_cb, &g_);
+      event_add(&ev_, {});
+    }
+  }
+
+  void release() noexcept
+  {
+    if ((-1 != efd_) && !--handles_) event_del(&ev_);
+  }
+
+public:
+  mailbox() = default;
+  ~mailbox() { if (-1 != efd_) close(efd_); }
+
+  mailbox(mailbox const&) = delete;
+
+  //
+  mailbox& operator=(mailbox const&) = delete;
+};
+
+static inline thread_local mailbox mail;
+
+}
+
+// a handle, through which any thread may unpause a coroutine, that waits
+// on it; wakeups, that arrive before the coroutine waits, are latched,
+// those, that arrive before the loop delivered the previous one, are
+// coalesced; the writes of the unpausing thread, that precede unpause(),
+// are visible to the coroutine, once it runs again; must be constructed
+// within a coroutine, like fd_event, and must outlive every unpause() call
+class remote_handle
+{
+  friend class detail::mailbox;
+
+private:
+  detail::mailbox& m_{detail::mail};
+
+  remote_handle* next_;
+  std::atomic<bool> queued_{};
+
+  gnr::forwarder<void() noexcept>* w_{};
+  bool woken_{};
+
+  void deliver() noexcept
+  {
+    queued_.exchange(false, std::memory_order_acq_rel);
+
+    if (w_)
+    {
+      (*std::exchange(w_, {}))();
+    }
+    else
+    {
+      woken_ = true;
+    }
+  }
+
+public:
+  remote_handle() noexcept { m_.acquire(); }
+
+  ~remote_handle()
+  { // a queued handle must not be left on the stack
+    if (queued_.load(std::memory_order_acquire)) m_.drain();
+
+    m_.release();
+  }
+
+  remote_handle(remote_handle const&) = delete;
+
+  //
+  remote_handle& operator=(remote_handle const&) = delete;
+
+  //
+  explicit operator bool() const noexcept { return -1 != m_.efd_; }
+
+  // thread-safe, lock-free
+  void unpause() noexcept
+  {
+    if (!queued_.exchange(true, std::memory_order_acq_rel))
+    {
+      auto& h(m_.head_);
+      auto const fd(m_.efd_);
+
+      auto n(h.load(std::memory_order_relaxed));
+
+      do
+      {
+        next_ = n;
+      }
+      while (!h.compare_exchange_weak(n, this,
+        std::memory_order_release, std::memory_order_relaxed));
+
+      if (!n)
+      { // the loop may be waiting
+        std::uint64_t const one(1);
+
+        while ((-1 == write(fd, &one, sizeof(one))) && (EINTR == errno));
+      }
+    }
+  }
+
+  // returns at once, if a wakeup is latched
+  void wait(auto& c) noexcept(noexcept(c.pause()))
+  {
+    if (!std::exchange(woken_, false))
+    {
+      gnr::forwarder<void() noexcept> g([&]() noexcept { c.unpause(); });
+
+      w_ = &g;
+      c.pause();
+
+      if (&g == w_) w_ = {};
+    }
+  }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+inline void detail::mailbox::drain() noexcept
+{
+  {
+    std::uint64_t n;
+
+    while ((-1 == read(efd_, &n, sizeof(n))) && (EINTR == errno));
+  }
+
+  // the stack is lifo, deliver in the order of the pushes
+  remote_handle* h{};
+
+  for (auto p(head_.exchange({}, std::memory_order_acquire)); p;)
+  {
+    auto const next(p->next_);
+
+    p->next_ = h;
+    h = p;
+
+    p = next;
+  }
+
+  while (h)
+  { // next_ is reused, once the handle is delivered
+    auto const next(h->next_);
+
+    h->deliver();
+
+    h = next;
+  }
+}
+
+//
+inline void await(auto& c, remote_handle& h) noexcept(noexcept(c.pause()))
+{
+  h.wait(c);
+}
+
+}
+
+#endif // CR2_REMOTE_HPP
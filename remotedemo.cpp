@@ -0,0 +1,135 @@
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "basic_coroutine.hpp"
+//#include "portable_coroutine.hpp"
+#include "remote.hpp"
+
+using namespace cr2::literals;
+
+// four coroutines offload work to a pool of threads, every job is
+// completed back into its coroutine through a remote handle
+struct job
+{
+  std::uint64_t n, r;
+  cr2::remote_handle* h;
+};
+
+class pool
+{
+  std::mutex m_;
+  std::condition_variable cv_;
+  std::deque<job*> q_;
+
+  bool stop_{};
+
+  std::vector<std::thread> t_;
+
+public:
+  explicit pool(unsigned n)
+  {
+    while (n--)
+    {
+      t_.emplace_back(
+        [this]()
+        {
+          for (;;)
+          {
+            job* j;
+
+            {
+              std::unique_lock l(m_);
+              cv_.wait(l, [&]() noexcept { return stop_ || !q_.empty(); });
+
+              if (q_.empty()) break;
+
+              j = q_.front();
+              q_.pop_front();
+            }
+
+            j->r = {};
+
+            for (std::uint64_t i{}; j->n != i; ++i) j->r += i * i;
+
+            j->h->unpause();
+          }
+        }
+      );
+    }
+  }
+
+  ~pool()
+  {
+    {
+      std::lock_guard l(m_);
+      stop_ = true;
+    }
+
+    cv_.notify_all();
+
+    for (auto& t: t_) t.join();
+  }
+
+  void submit(job& j)
+  {
+    {
+      std::lock_guard l(m_);
+      q_.push_back(&j);
+    }
+
+    cv_.notify_one();
+  }
+};
+
+int main()
+{
+  evthread_use_pthreads();
+
+  pool p(2);
+
+  auto const worker(
+    [&]() noexcept
+    {
+      return [&](auto& c)
+        {
+          cr2::remote_handle h;
+
+          std::uint64_t s{};
+
+          for (std::uint64_t i{}; 1000 != i; ++i)
+          {
+            job j{i, {}, &h};
+
+            p.submit(j);
+            cr2::await(c, h);
+
+            if (j.r != (i ? (i - 1) * i * (2 * i - 1) / 6 : 0)) return s;
+
+            ++s;
+          }
+
+          return s;
+        };
+    }
+  );
+
+  auto const r(
+    cr2::make_and_run<64_k, 64_k, 64_k, 64_k>(
+      worker(), worker(), worker(), worker()
+    )
+  );
+
+  std::cout <<
+    std::get<0>(r) + std::get<1>(r) + std::get<2>(r) + std::get<3>(r) <<
+    " of 4000 jobs completed\n";
+
+  event_base_free(std::exchange(cr2::base, {}));
+  libevent_global_shutdown();
+
+  return 0;
+}
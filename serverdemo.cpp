@@ -0,0 +1,77 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "basic_coroutine.hpp"
+//#include "portable_coroutine.hpp"
+#include "tcp_server.hpp"
+
+using namespace cr2::literals;
+
+// an echo server on port 7777, load it with tcpload; an optional argument
+// stops the server after that many connections
+int main(int const argc, char* argv[])
+{
+  evthread_use_pthreads();
+
+  auto m(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 0);
+
+  evutil_socket_t l;
+
+  auto s(cr2::make_tcp_server<64_k>(
+      [&](auto& c, evutil_socket_t const fd)
+      {
+        cr2::fd_event e(fd);
+
+        for (char buf[4096];;)
+        {
+          if (auto const sz(recv(fd, buf, sizeof(buf), 0)); sz > 0)
+          {
+            for (ssize_t o{}; sz != o;)
+            {
+              if (auto const w(send(fd, buf + o, sz - o, MSG_NOSIGNAL));
+                -1 != w)
+              {
+                o += w;
+              }
+              else if ((EAGAIN == errno) || (EWOULDBLOCK == errno))
+              {
+                cr2::await(c, e, EV_WRITE);
+              }
+              else
+              {
+                return;
+              }
+            }
+          }
+          else if (!sz || ((EAGAIN != errno) && (EWOULDBLOCK != errno)))
+          {
+            break;
+          }
+          else
+          {
+            cr2::await(c, e, EV_READ);
+          }
+        }
+
+        if (m && !--m) shutdown(l, SHUT_RD); // what stop() does
+      }
+    )
+  );
+
+  if (!s.listen("127.0.0.1", 7777, true))
+  {
+    std::cerr << "listen(): " << evutil_socket_error_to_string(errno) << '\n';
+
+    return EXIT_FAILURE;
+  }
+
+  l = s.fd();
+
+  cr2::make_and_run<128_k>([&](auto& c) { s.serve(c); });
+
+  event_base_free(std::exchange(cr2::base, {}));
+  libevent_global_shutdown();
+
+  return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef CR2_SHARD_HPP
+# define CR2_SHARD_HPP
+# pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <thread>
+#include <vector>
+
+namespace cr2
+{
+
+// calls f(i) on n threads, i = 0, ..., n - 1, thread i is pinned to the
+// i-th cpu of the affinity mask of the process, n = 0 starts a thread per
+// cpu; the backends keep their loop, timers and fd tables per thread, so
+// every f(i) can run() a loop of its own and the shards share nothing, but
+// f itself, that must be safe to call concurrently
+void run_sharded(auto&& f, unsigned n = {})
+{
+  std::vector<int> cpus;
+
+  {
+    cpu_set_t s;
+
+    if (!sched_getaffinity(0, sizeof(s), &s))
+    {
+      for (int i{}; CPU_SETSIZE != i; ++i)
+      {
+        if (CPU_ISSET(i, &s)) cpus.push_back(i);
+      }
+    }
+  }
+
+  if (!n)
+  {
+    n = cpus.empty() ? std::thread::hardware_concurrency() : cpus.size();
+  }
+
+  std::vector<std::thread> t;
+  t.reserve(n);
+
+  for (unsigned i{}; n != i; ++i)
+  {
+    t.emplace_back(
+      [&f, i, cpu(cpus.empty() ? -1 : cpus[i % cpus.size()])]()
+      {
+        if (-1 != cpu)
+        {
+          cpu_set_t s;
+          CPU_ZERO(&s);
+          CPU_SET(cpu, &s);
+
+          pthread_setaffinity_np(pthread_self(), sizeof(s), &s);
+        }
+
+        f(i);
+      }
+    );
+  }
+
+  for (auto& th: t) th.join();
+}
+
+}
+
+#endif // CR2_SHARD_HPP
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+#include "basic_coroutine.hpp"
+//#include "portable_coroutine.hpp"
+#include "shard.hpp"
+#include "tcp_server.hpp"
+
+using namespace cr2::literals;
+
+// the echo server of serverdemo, with a listener and a loop per cpu, all on
+// port 7777; an optional argument stops the shards after that many
+// connections, an optional second one sets the number of shards
+int main(int const argc, char* argv[])
+{
+  evthread_use_pthreads();
+
+  auto const m(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 0);
+  auto const n(argc > 2 ? unsigned(std::strtoul(argv[2], nullptr, 10)) :
+    std::thread::hardware_concurrency());
+
+  std::atomic<std::size_t> served{};
+  auto const lfds(std::make_unique<std::atomic<evutil_socket_t>[]>(n));
+  std::fill_n(lfds.get(), n, -1);
+
+  cr2::run_sharded(
+    [&](unsigned const i)
+    {
+      auto s(cr2::make_tcp_server<64_k>(
+          [&](auto& c, evutil_socket_t const fd)
+          {
+            cr2::fd_event e(fd);
+
+            for (char buf[4096];;)
+            {
+              if (auto const sz(recv(fd, buf, sizeof(buf), 0)); sz > 0)
+              {
+                if (cr2::write_all(c, e, iovec{buf, std::size_t(sz)}) < 0)
+                {
+                  break;
+                }
+              }
+              else if (!sz || ((EAGAIN != errno) && (EWOULDBLOCK != errno)))
+              {
+                break;
+              }
+              else
+              {
+                cr2::await(c, e, EV_READ);
+              }
+            }
+
+            if (m && (m == ++served))
+            { // stop every shard, shutdown() is safe from any thread
+              for (unsigned j{}; n != j; ++j)
+              {
+                if (-1 != lfds[j]) shutdown(lfds[j], SHUT_RD);
+              }
+            }
+          }
+        )
+      );
+
+      if (s.listen("127.0.0.1", 7777, true))
+      {
+        lfds[i] = s.fd();
+
+        cr2::make_and_run<128_k>([&](auto& c) { s.serve(c); });
+      }
+      else
+      {
+        std::cerr << "shard " << i << ": listen() failed\n";
+      }
+    }, // the base of the shard is freed, when its thread exits
+    n
+  );
+
+  std::cout << served << " connections served by " << n << " shards\n";
+
+  libevent_global_shutdown();
+
+  return 0;
+}
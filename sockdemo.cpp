@@ -3,7 +3,7 @@
 
 #include "basic_coroutine.hpp"
 //#include "portable_coroutine.hpp"
-#include "libevent_support.hpp"
+#include "stream.hpp"
 
 using namespace cr2::literals;
 using namespace std::literals::string_literals;
@@ -59,30 +59,21 @@ int main()
           }
         }
 
+        cr2::stream st(sck); // registered once, for the whole loop
+
         std::string s;
 
-        for (char buf[128];;)
+        for (;;)
         {
           std::cout << "coro1\n";
 
-          if (int sz; -1 == (sz = recv(sck, buf, sizeof(buf), 0)))
+          if (auto const v(st.read_some(c)); v.size())
           {
-            if ((EAGAIN == errno) || (EWOULDBLOCK == errno))
-            {
-              std::cout << "pausing\n";
-              cr2::await(c, EV_CLOSED|EV_READ, sck);
-
-              continue;
-            }
-            else
-            {
-              return "recv(): "s +
-                evutil_socket_error_to_string(evutil_socket_geterror(sck));
-            }
+            s.append(v);
           }
-          else if (sz)
+          else if (st.error())
           {
-            s.append(buf, sz);
+            return "recv(): "s + evutil_socket_error_to_string(st.error());
           }
           else
           {
@@ -98,7 +89,7 @@ int main()
   std::cout << std::get<1>(t) << std::endl;
   std::cout << std::get<0>(t) << std::endl;
 
-  event_base_free(cr2::base);
+  event_base_free(std::exchange(cr2::base, {}));
   libevent_global_shutdown();
 
   return 0;
@@ -0,0 +1,67 @@
+#include <iostream>
+#include <memory>
+
+#include "basic_coroutine.hpp"
+//#include "portable_coroutine.hpp"
+#include "libevent_support.hpp"
+
+using namespace cr2::literals;
+
+// spawned coroutines, that destroy one another, while they are queued or
+// paused; the loop must neither crash, nor wait for the destroyed ones
+struct spinner
+{
+  void operator()(auto& c) { for (;;) c.suspend(); }
+};
+
+struct sleeper
+{
+  void operator()(auto& c) { c.pause(); }
+};
+
+int main()
+{
+  std::unique_ptr<cr2::coroutine<spinner, cr2::detail::empty_t, 64_k>> b2(
+    new cr2::coroutine<spinner, cr2::detail::empty_t, 64_k>(spinner{})
+  );
+
+  std::unique_ptr<cr2::coroutine<sleeper, cr2::detail::empty_t, 64_k>> b3(
+    new cr2::coroutine<sleeper, cr2::detail::empty_t, 64_k>(sleeper{})
+  );
+
+  // b1 runs ahead of b2 in every tick, it destroys b2 mid-tick
+  auto b1(
+    cr2::make_plain<64_k>(
+      [&](auto& c)
+      {
+        c.suspend();
+
+        b2.reset();
+        std::cout << "queued coroutine destroyed\n";
+
+        b3.reset();
+        std::cout << "paused coroutine destroyed\n";
+      }
+    )
+  );
+
+  cr2::make_and_run<64_k>(
+    [&](auto& c)
+    {
+      cr2::spawn(c, b1);
+      cr2::spawn(c, *b2);
+      cr2::spawn(c, *b3);
+
+      c.suspend();
+      c.suspend();
+      c.suspend();
+    }
+  );
+
+  std::cout << "loop returned\n";
+
+  event_base_free(std::exchange(cr2::base, {}));
+  libevent_global_shutdown();
+
+  return 0;
+}
@@ -0,0 +1,326 @@
+#ifndef CR2_STACK_HPP
+# define CR2_STACK_HPP
+# pragma once
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstddef> // std::max_align_t
+#include <new> // std::align_val_t, std::bad_alloc
+#include <utility> // std::exchange
+
+#if defined(CR2_STACK_WATERMARK)
+# include <algorithm> // std::fill, std::find_if
+# include <array>
+# include <atomic>
+# include <bit> // std::bit_ceil, std::bit_width
+# include <cstdint> // std::uintptr_t
+#endif
+
+#include "common.hpp"
+
+namespace cr2
+{
+
+#if defined(CR2_STACK_WATERMARK)
+template <std::size_t S>
+class stack_stats
+{
+private:
+  enum : std::size_t { B = std::bit_width(S) + 1 };
+
+  static inline std::atomic<std::size_t> histogram_[B], max_;
+
+public:
+  // bucket i counts the stacks, whose deepest use was < 2^i bytes
+  static auto histogram() noexcept
+  {
+    std::array<std::size_t, B> h;
+
+    std::transform(
+      std::begin(histogram_),
+      std::end(histogram_),
+      h.begin(),
+      [](auto& e) noexcept { return e.load(std::memory_order_relaxed); }
+    );
+
+    return h;
+  }
+
+  static std::size_t max() noexcept
+  {
+    return max_.load(std::memory_order_relaxed);
+  }
+
+  static void record(std::size_t const u) noexcept
+  {
+    histogram_[std::bit_width(u)].fetch_add(1, std::memory_order_relaxed);
+
+    for (auto m(max()); (m < u) &&
+      !max_.compare_exchange_weak(m, u, std::memory_order_relaxed););
+  }
+
+  // twice the deepest use seen so far, rounded up to a power of 2
+  static std::size_t suggested_size() noexcept
+  {
+    return std::bit_ceil(2 * max());
+  }
+};
+
+#endif
+
+namespace detail
+{
+
+#if defined(CR2_STACK_WATERMARK)
+inline constexpr std::uintptr_t canary(0xa5a5a5a5a5a5a5a5);
+
+// painting commits the whole stack, watermarks are a diagnostic mode
+inline void paint(void* const b, void* const t) noexcept
+{
+  std::fill(
+    static_cast<std::uintptr_t*>(b),
+    static_cast<std::uintptr_t*>(t),
+    canary
+  );
+}
+
+inline std::size_t used(void const* const b, void const* const t) noexcept
+{
+  auto const e(static_cast<std::uintptr_t const*>(t));
+
+  return sizeof(std::uintptr_t) * (e - std::find_if(
+      static_cast<std::uintptr_t const*>(b),
+      e,
+      [](auto const w) noexcept { return canary != w; }
+    )
+  );
+}
+
+#endif
+
+struct heap_allocator
+{
+  static void* allocate(std::size_t const sz)
+  {
+    return ::operator new(sz, std::align_val_t(alignof(std::max_align_t)));
+  }
+
+  static void deallocate(void* const p, std::size_t const sz) noexcept
+  {
+    ::operator delete(p, sz, std::align_val_t(alignof(std::max_align_t)));
+  }
+
+  static void recycle(void*, std::size_t) noexcept { }
+};
+
+struct mmap_allocator
+{
+  static std::size_t page_size() noexcept
+  {
+    static std::size_t const ps(sysconf(_SC_PAGESIZE));
+
+    return ps;
+  }
+
+  static void* allocate(std::size_t const sz)
+  { // the mapping is only reserved, pages are committed, when touched
+    auto const ps(page_size());
+
+    if (auto const p(mmap(nullptr, ps + sz, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0));
+      MAP_FAILED == p)
+    {
+      throw std::bad_alloc();
+    }
+    else if (mprotect(p, ps, PROT_NONE)) // guard page below the stack
+    { // no unguarded stacks
+      munmap(p, ps + sz);
+
+      throw std::bad_alloc();
+    }
+    else
+    {
+      return static_cast<char*>(p) + ps;
+    }
+  }
+
+  static void deallocate(void* const p, std::size_t const sz) noexcept
+  {
+    auto const ps(page_size());
+
+    munmap(static_cast<char*>(p) - ps, ps + sz);
+  }
+
+  static void recycle(void* const p, std::size_t const sz) noexcept
+  { // give back all pages but the topmost one
+    auto const ps(page_size());
+
+    if (auto const l((sz - 1) / ps * ps); l)
+    {
+      madvise(p, l, MADV_DONTNEED);
+    }
+  }
+};
+
+template <std::size_t S, typename P>
+class stack_pool
+{
+private:
+  struct free_list
+  {
+    void* head_{};
+    std::size_t size_{}, capacity_{64};
+
+    ~free_list() { clear(); }
+
+    void clear() noexcept
+    {
+      for (; head_; --size_)
+      {
+        P::deallocate(std::exchange(head_, next(head_)), S);
+      }
+    }
+  };
+
+  static inline thread_local free_list fl_;
+
+  // a free stack is linked through its topmost slot, the slot that is
+  // touched first by the next coroutine anyway
+  static void*& next(void* const p) noexcept
+  {
+    return static_cast<void**>(p)[S / sizeof(void*) - 1];
+  }
+
+public:
+  static void* allocate(std::size_t)
+  {
+    if (auto const p(fl_.head_); p)
+    {
+      --fl_.size_;
+      fl_.head_ = next(p);
+
+      return p;
+    }
+    else
+    {
+      return P::allocate(S);
+    }
+  }
+
+  static void deallocate(void* const p, std::size_t) noexcept
+  {
+    if (fl_.size_ < fl_.capacity_)
+    {
+      P::recycle(p, S);
+
+      ++fl_.size_;
+      next(p) = std::exchange(fl_.head_, p);
+    }
+    else
+    {
+      P::deallocate(p, S);
+    }
+  }
+
+  //
+  static void capacity(std::size_t const c) noexcept { fl_.capacity_ = c; }
+  static void trim() noexcept { fl_.clear(); }
+};
+
+template <std::size_t S, typename A>
+class dynamic_stack
+{
+  static_assert(!(S % alignof(std::max_align_t)));
+
+private:
+  void* const s_;
+
+public:
+  dynamic_stack(): s_(A::allocate(S))
+  {
+#if defined(CR2_STACK_WATERMARK)
+    paint(s_, top());
+#endif
+  }
+
+  ~dynamic_stack()
+  {
+#if defined(CR2_STACK_WATERMARK)
+    stack_stats<S>::record(used());
+#endif
+
+    A::deallocate(s_, S);
+  }
+
+  dynamic_stack(dynamic_stack const&) = delete;
+
+  //
+  dynamic_stack& operator=(dynamic_stack const&) = delete;
+
+  //
+  void* top() const noexcept { return static_cast<char*>(s_) + S; }
+
+#if defined(CR2_STACK_WATERMARK)
+  std::size_t used() const noexcept { return detail::used(s_, top()); }
+#endif
+
+  //
+  static void capacity(std::size_t const c) noexcept
+    requires(requires{A::capacity(c);})
+  {
+    A::capacity(c);
+  }
+
+  static void trim() noexcept requires(requires{A::trim();}) { A::trim(); }
+};
+
+}
+
+// the stack is a part of the coroutine object
+template <std::size_t S>
+class inline_stack
+{
+private:
+  enum : std::size_t { N = S / sizeof(void*) };
+
+  alignas(std::max_align_t) void* stack_[N];
+
+public:
+#if defined(CR2_STACK_WATERMARK)
+  inline_stack() noexcept { detail::paint(stack_, &stack_[N]); }
+  ~inline_stack() { stack_stats<S>::record(used()); }
+
+  inline_stack(inline_stack const&) = delete;
+
+  //
+  inline_stack& operator=(inline_stack const&) = delete;
+
+  //
+  std::size_t used() const noexcept { return detail::used(stack_, &stack_[N]); }
+#endif
+
+  void* top() noexcept { return &stack_[N]; }
+};
+
+// every coroutine allocates its own stack from the heap
+template <std::size_t S>
+using heap_stack = detail::dynamic_stack<S, detail::heap_allocator>;
+
+// stacks of equal size are recycled through a per-thread free-list
+template <std::size_t S>
+using pooled_stack = detail::dynamic_stack<S,
+  detail::stack_pool<S, detail::heap_allocator>>;
+
+// a lazily committed mapping with a guard page below it
+template <std::size_t S>
+using mmap_stack = detail::dynamic_stack<S, detail::mmap_allocator>;
+
+// recycled mappings return their pages to the os
+template <std::size_t S>
+using pooled_mmap_stack = detail::dynamic_stack<S,
+  detail::stack_pool<S, detail::mmap_allocator>>;
+
+}
+
+#endif // CR2_STACK_HPP
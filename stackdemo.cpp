@@ -0,0 +1,99 @@
+#define CR2_STACK_WATERMARK
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+
+#include "basic_coroutine.hpp"
+//#include "portable_coroutine.hpp"
+#include "libnone_support.hpp"
+
+using namespace cr2::literals;
+
+// every level uses a little more than 256 bytes of stack
+__attribute__((noinline)) unsigned recurse(unsigned const d) noexcept
+{
+  volatile char buf[256];
+  buf[d % sizeof(buf)] = 1;
+
+  return d ? recurse(d - 1) + buf[d % sizeof(buf)] : 0;
+}
+
+// runs coroutines of different depths on stacks of policy A, then prints
+// the deepest use and the histogram of the stacks of size S
+template <std::size_t S, template <std::size_t> class A>
+void report(char const* const name)
+{
+  auto const coro([](unsigned const d) noexcept
+    {
+      return [d](auto& c) noexcept
+        {
+          c.suspend();
+
+          return recurse(d);
+        };
+    }
+  );
+
+  cr2::run(
+    cr2::make_plain<S, A>(coro(4)),
+    cr2::make_plain<S, A>(coro(16)),
+    cr2::make_plain<S, A>(coro(64))
+  );
+
+  std::cout << name << " max " << cr2::stack_stats<S>::max() <<
+    " suggested " << cr2::stack_stats<S>::suggested_size() << " histogram";
+
+  for (std::size_t i{}; auto const n: cr2::stack_stats<S>::histogram())
+  {
+    if (n) std::cout << " <2^" << i << ':' << n;
+
+    ++i;
+  }
+
+  std::cout << '\n';
+}
+
+// with an argument, a coroutine overflows into the guard page of its stack
+int main(int const argc, char*[])
+{
+  if (argc > 1)
+  { // the handler needs a stack of its own
+    static char ss[64_k];
+
+    stack_t const st{.ss_sp = ss, .ss_flags = {}, .ss_size = sizeof(ss)};
+    sigaltstack(&st, {});
+
+    struct sigaction sa{};
+    sa.sa_handler = [](int) noexcept
+      {
+        char const m[] = "guard page hit\n";
+
+        write(STDERR_FILENO, m, sizeof(m) - 1);
+        _exit(0);
+      };
+    sa.sa_flags = SA_ONSTACK;
+    sigaction(SIGSEGV, &sa, {});
+
+    cr2::run(
+      cr2::make_plain<16_k, cr2::mmap_stack>(
+        [](auto&) noexcept { recurse(1000); }
+      )
+    );
+
+    std::cout << "no overflow\n";
+
+    return 1;
+  }
+
+  // each policy gets its own size, the stats are kept per size
+  report<32_k, cr2::inline_stack>("inline_stack");
+  report<48_k, cr2::heap_stack>("heap_stack");
+  report<64_k, cr2::pooled_stack>("pooled_stack");
+  report<80_k, cr2::mmap_stack>("mmap_stack");
+  report<96_k, cr2::pooled_mmap_stack>("pooled_mmap_stack");
+
+  return 0;
+}
@@ -0,0 +1,229 @@
+#ifndef CR2_STREAM_HPP
+# define CR2_STREAM_HPP
+# pragma once
+
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstring> // std::memchr, std::memcpy, std::memmove
+#include <memory> // std::unique_ptr
+#include <string_view>
+
+#include "libevent_support.hpp"
+
+namespace cr2
+{
+
+// buffered reads and writes on a non-blocking socket, that is not owned;
+// the views returned by the reads point into the read buffer and stay valid
+// until the next read; writes are coalesced, until the write buffer fills
+// up, flush() is called or a read has to wait for the peer; must be
+// constructed within a coroutine, like fd_event
+template <std::size_t R = 16 * 1024, std::size_t W = 16 * 1024>
+class stream
+{
+  static_assert(R && W);
+
+private:
+  fd_event e_;
+
+  std::unique_ptr<char[]> const b_{new char[R + W]}; // read, then write
+  std::size_t rh_{}, rt_{}, wt_{}; // unread [rh_, rt_), unsent [R, R + wt_)
+
+  int error_{};
+  bool eof_{};
+
+  void compact() noexcept
+  {
+    std::memmove(&b_[0], &b_[rh_], rt_ -= rh_);
+    rh_ = {};
+  }
+
+  bool fill(auto& c)
+  {
+    if (rh_ == rt_)
+    {
+      rh_ = rt_ = {};
+    }
+    else if (R == rt_)
+    {
+      compact();
+    }
+
+    for (;;)
+    {
+      if (auto const sz(recv(fd(), &b_[rt_], R - rt_, 0)); sz > 0)
+      {
+        rt_ += sz;
+
+        return true;
+      }
+      else if (!sz)
+      {
+        eof_ = true;
+      }
+      else if (EINTR == errno)
+      {
+        continue;
+      }
+      else if ((EAGAIN == errno) || (EWOULDBLOCK == errno))
+      { // the peer may wait for our writes
+        if (flush(c))
+        {
+          await(c, e_, EV_READ);
+
+          continue;
+        }
+      }
+      else
+      {
+        error_ = errno;
+      }
+
+      return false;
+    }
+  }
+
+  bool send_all(auto& c, char const* p, std::size_t n)
+  {
+    while (n)
+    {
+      if (auto const sz(send(fd(), p, n, MSG_NOSIGNAL)); -1 != sz)
+      {
+        p += sz;
+        n -= sz;
+      }
+      else if (EINTR == errno)
+      {
+        continue;
+      }
+      else if ((EAGAIN == errno) || (EWOULDBLOCK == errno))
+      {
+        await(c, e_, EV_WRITE);
+      }
+      else
+      {
+        error_ = errno;
+
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+public:
+  explicit stream(evutil_socket_t const fd) noexcept: e_(fd) { }
+
+  stream(stream const&) = delete;
+
+  //
+  stream& operator=(stream const&) = delete;
+
+  //
+  explicit operator bool() const noexcept { return !error_ && !eof_; }
+
+  //
+  bool eof() const noexcept { return eof_; }
+  int error() const noexcept { return error_; }
+  evutil_socket_t fd() const noexcept { return e_.fd(); }
+
+  // bytes buffered for reading and for writing
+  auto available() const noexcept { return rt_ - rh_; }
+  auto pending() const noexcept { return wt_; }
+
+  // the buffered bytes, reads once, if there are none; empty at eof
+  std::string_view read_some(auto& c)
+  {
+    if ((rh_ != rt_) || fill(c))
+    {
+      auto const h(std::exchange(rh_, rt_));
+
+      return {&b_[h], rt_ - h};
+    }
+    else
+    {
+      return {};
+    }
+  }
+
+  // up to and including d; empty at eof, or if no d fits into the buffer
+  std::string_view read_until(auto& c, char const d)
+  {
+    for (auto o(rh_);;) // o is where the search continues
+    {
+      if (auto const p(static_cast<char*>(
+        std::memchr(&b_[o], d, rt_ - o))); p)
+      {
+        auto const h(rh_);
+
+        return {&b_[h], std::size_t((rh_ = p - &b_[0] + 1) - h)};
+      }
+      else if (R == rt_ - rh_)
+      {
+        error_ = ENOBUFS;
+
+        return {};
+      }
+      else if (auto const s(rt_ - rh_); fill(c))
+      {
+        o = rh_ + s;
+      }
+      else
+      {
+        return {};
+      }
+    }
+  }
+
+  // exactly n bytes; empty at eof, or if n exceeds the buffer
+  std::string_view read_exact(auto& c, std::size_t const n)
+  {
+    if (n > R)
+    {
+      error_ = EMSGSIZE;
+
+      return {};
+    }
+    else
+    {
+      while (rt_ - rh_ < n)
+      {
+        if (rh_ + n > R) compact();
+
+        if (!fill(c)) return {};
+      }
+
+      return {&b_[std::exchange(rh_, rh_ + n)], n};
+    }
+  }
+
+  //
+  bool write(auto& c, std::string_view const s)
+  {
+    if ((s.size() > W - wt_) && !flush(c))
+    {
+      return false;
+    }
+    else if (s.size() > W)
+    { // too large to buffer
+      return send_all(c, s.data(), s.size());
+    }
+    else
+    {
+      std::memcpy(&b_[R + wt_], s.data(), s.size());
+      wt_ += s.size();
+
+      return true;
+    }
+  }
+
+  bool flush(auto& c)
+  {
+    return send_all(c, &b_[R], std::exchange(wt_, {}));
+  }
+};
+
+}
+
+#endif // CR2_STREAM_HPP
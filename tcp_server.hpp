@@ -0,0 +1,216 @@
+#ifndef CR2_TCP_SERVER_HPP
+# define CR2_TCP_SERVER_HPP
+# pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <memory> // std::unique_ptr
+#include <vector>
+
+#include "libevent_support.hpp"
+
+namespace cr2
+{
+
+// runs a coroutine per accepted connection, f(c, fd), the socket is closed,
+// when f returns; every edge of the listening socket drains its accept
+// queue; connection coroutines, together with their stacks, are recycled;
+// several servers, each listening with reuseport, share the port and the
+// kernel spreads the connections among them
+template <typename F, std::size_t S = 64 * 1024,
+  template <std::size_t> class A = pooled_stack>
+class tcp_server
+{
+private:
+  struct node;
+
+  struct body
+  {
+    node* n_;
+
+    void operator()(auto& c) { tcp_server::connection(c, n_); }
+  };
+
+  struct node
+  {
+    tcp_server* s_;
+    evutil_socket_t fd_;
+
+    coroutine<body, detail::empty_t, S, A> c_{body{this}};
+  };
+
+  F f_;
+
+  evutil_socket_t lfd_{-1};
+
+  std::vector<std::unique_ptr<node>> nodes_;
+  std::vector<node*> free_;
+
+  std::size_t live_{};
+
+  void* drainer_{}; // the coroutine, that waits in serve()
+  void (*unpause_)(void*) noexcept;
+
+  static void connection(auto& c, node* const n)
+  {
+    auto const s(n->s_);
+
+    SCOPE_EXIT(&, s->release(n));
+
+    s->f_(c, n->fd_);
+  }
+
+  void release(node* const n) noexcept
+  {
+    evutil_closesocket(n->fd_);
+    free_.push_back(n); // DEAD, by the time the listener runs again
+
+    if (!--live_ && drainer_) unpause_(std::exchange(drainer_, {}));
+  }
+
+  // fails, if no loop runs c
+  bool spawn(auto& c, evutil_socket_t const fd)
+  {
+    node* n;
+
+    if (free_.empty())
+    {
+      n = nodes_.emplace_back(new node{this, -1}).get();
+    }
+    else
+    {
+      n = free_.back();
+      free_.pop_back();
+
+      n->c_.reset();
+    }
+
+    n->fd_ = fd;
+
+    if (cr2::spawn(c, n->c_))
+    {
+      ++live_;
+
+      return true;
+    }
+    else
+    {
+      evutil_closesocket(fd);
+      free_.push_back(n);
+
+      return false;
+    }
+  }
+
+public:
+  explicit tcp_server(auto&& f):
+    f_(std::forward<decltype(f)>(f))
+  {
+  }
+
+  ~tcp_server() { if (-1 != lfd_) evutil_closesocket(lfd_); }
+
+  tcp_server(tcp_server const&) = delete;
+
+  //
+  tcp_server& operator=(tcp_server const&) = delete;
+
+  //
+  explicit operator bool() const noexcept { return -1 != lfd_; }
+
+  //
+  auto connections() const noexcept { return live_; }
+  evutil_socket_t fd() const noexcept { return lfd_; }
+
+  //
+  bool listen(char const* const addr, std::uint16_t const port,
+    bool const reuseport = false, int const backlog = SOMAXCONN) noexcept
+  {
+    struct sockaddr_in sin{};
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+
+    if ((1 != evutil_inet_pton(AF_INET, addr, &sin.sin_addr)) ||
+      (-1 == (lfd_ = socket(AF_INET,
+        SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP))))
+    {
+      return false;
+    }
+
+    int const on(1);
+
+    if ((-1 == setsockopt(lfd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on))) ||
+      (reuseport &&
+        (-1 == setsockopt(lfd_, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)))) ||
+      (-1 == bind(lfd_, reinterpret_cast<sockaddr*>(&sin), sizeof(sin))) ||
+      (-1 == ::listen(lfd_, backlog)))
+    {
+      evutil_closesocket(std::exchange(lfd_, -1));
+
+      return false;
+    }
+
+    return true;
+  }
+
+  // wakes the listener, that stops accepting
+  void stop() noexcept { shutdown(lfd_, SHUT_RD); }
+
+  // accepts, until stop() is called, then waits for the connections to end;
+  // c must be run by a loop, else serve() returns at the first connection
+  void serve(auto& c)
+  {
+    for (fd_event e(lfd_, EV_READ); e;)
+    {
+      if (auto const fd(accept4(lfd_, {}, {}, SOCK_NONBLOCK | SOCK_CLOEXEC));
+        -1 != fd)
+      {
+        if (!spawn(c, fd)) break;
+      }
+      else if ((EINTR == errno) || (ECONNABORTED == errno))
+      {
+        continue;
+      }
+      else if ((EAGAIN == errno) || (EWOULDBLOCK == errno))
+      {
+        await(c, e, EV_READ);
+      }
+      else if ((EMFILE == errno) || (ENFILE == errno) ||
+        (ENOBUFS == errno) || (ENOMEM == errno))
+      { // out of resources, back off, until connections end
+        await(c, std::chrono::milliseconds(10));
+      }
+      else
+      {
+        break;
+      }
+    }
+
+    if (live_)
+    {
+      using C = std::remove_cvref_t<decltype(c)>;
+
+      drainer_ = &c;
+      unpause_ = [](void* const p) noexcept { static_cast<C*>(p)->unpause(); };
+
+      c.pause();
+    }
+  }
+};
+
+template <std::size_t S = 64 * 1024,
+  template <std::size_t> class A = pooled_stack>
+auto make_tcp_server(auto&& f)
+{
+  return tcp_server<std::remove_cvref_t<decltype(f)>, S, A>(
+    std::forward<decltype(f)>(f)
+  );
+}
+
+}
+
+#endif // CR2_TCP_SERVER_HPP
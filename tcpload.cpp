@@ -0,0 +1,141 @@
+#include <netinet/tcp.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "basic_coroutine.hpp"
+//#include "portable_coroutine.hpp"
+#include "libevent_support.hpp"
+
+using namespace cr2::literals;
+using namespace std::literals::chrono_literals;
+
+// a load generator for serverdemo:
+//
+//   tcpload [connections] [requests per connection] [request size]
+//
+// every connection sends a request, waits for the whole echo, and repeats
+int main(int const argc, char* argv[])
+{
+  evthread_use_pthreads();
+
+  auto const arg([&](int const i, std::size_t const d) noexcept
+    {
+      return argc > i ? std::strtoull(argv[i], nullptr, 10) : d;
+    }
+  );
+
+  auto const n(arg(1, 100)), k(arg(2, 10000)), b(arg(3, 64));
+
+  std::size_t done{}, failed{};
+
+  auto const client(
+    [&]() noexcept
+    {
+      return [&](auto& c)
+        {
+          SCOPE_EXIT(&, ++done);
+
+          evutil_socket_t const fd(socket(AF_INET,
+            SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP));
+          SCOPE_EXIT(&, evutil_closesocket(fd));
+
+          int const on(1);
+          setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+          struct sockaddr_in sin{};
+          sin.sin_family = AF_INET;
+          sin.sin_port = htons(7777);
+          evutil_inet_pton(AF_INET, "127.0.0.1", &sin.sin_addr);
+
+          cr2::fd_event e(fd);
+
+          if ((-1 == connect(fd, reinterpret_cast<sockaddr*>(&sin),
+            sizeof(sin))) && ((EINPROGRESS != errno) ||
+            (EV_CLOSED & cr2::await(c, e, EV_WRITE))))
+          {
+            ++failed;
+
+            return;
+          }
+
+          std::vector<char> buf(b, 'x');
+
+          for (auto i(k); i; --i)
+          {
+            for (std::size_t o{}; b != o;)
+            {
+              if (auto const w(send(fd, &buf[o], b - o, MSG_NOSIGNAL));
+                -1 != w)
+              {
+                o += w;
+              }
+              else if (EAGAIN == errno)
+              {
+                cr2::await(c, e, EV_WRITE);
+              }
+              else
+              {
+                ++failed;
+
+                return;
+              }
+            }
+
+            for (std::size_t o{}; b != o;)
+            {
+              if (auto const r(recv(fd, &buf[o], b - o, 0)); r > 0)
+              {
+                o += r;
+              }
+              else if (r && (EAGAIN == errno))
+              {
+                cr2::await(c, e, EV_READ);
+              }
+              else
+              {
+                ++failed;
+
+                return;
+              }
+            }
+          }
+        };
+    }
+  );
+
+  using C = decltype(cr2::make_unique<64_k, cr2::pooled_stack>(client()));
+
+  auto const t0(std::chrono::steady_clock::now());
+
+  cr2::make_and_run<128_k>(
+    [&](auto& c)
+    {
+      std::vector<C> v;
+      v.reserve(n);
+
+      for (auto i(n); i; --i)
+      {
+        cr2::spawn(c,
+          *v.emplace_back(cr2::make_unique<64_k, cr2::pooled_stack>(client()))
+        );
+      }
+
+      while (n != done) cr2::await(c, 10ms);
+    }
+  );
+
+  auto const s(std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - t0).count());
+
+  std::cout << n << " connections, " << failed << " failed, " <<
+    (n - failed) * k / s << " requests/s\n";
+
+  event_base_free(std::exchange(cr2::base, {}));
+  libevent_global_shutdown();
+
+  return 0;
+}
@@ -0,0 +1,209 @@
+#ifndef CR2_TIMER_WHEEL_HPP
+# define CR2_TIMER_WHEEL_HPP
+# pragma once
+
+#include <algorithm> // std::max, std::min
+#include <chrono>
+#include <cstdint>
+#include <utility> // std::exchange
+
+#include "generic/forwarder.hpp"
+
+#include "common.hpp"
+
+namespace cr2
+{
+
+// hierarchical timer wheel with millisecond ticks, L levels of N slots,
+// level l holds the timers due within N^(l + 1) ticks and is cascaded
+// into the levels below, whenever the level below wraps around; timers
+// are intrusive and live in the frames of the waiting coroutines, insert
+// and cancel are O(1)
+class timer_wheel
+{
+public:
+  using clock = std::chrono::steady_clock;
+
+  class timer
+  {
+    friend class timer_wheel;
+
+  private:
+    timer_wheel* w_{};
+    timer** h_; // list head
+    timer* prev_, *next_;
+
+    std::uint64_t due_;
+
+    gnr::forwarder<void() noexcept> f_;
+
+  public:
+    explicit timer(auto&& f) noexcept: f_(std::forward<decltype(f)>(f)) { }
+    ~timer() { if (w_) w_->remove(*this); }
+
+    timer(timer const&) = delete;
+
+    //
+    timer& operator=(timer const&) = delete;
+
+    //
+    explicit operator bool() const noexcept { return w_; }
+  };
+
+private:
+  enum : unsigned { B = 6, L = 4 };
+  enum : std::uint64_t { N = std::uint64_t(1) << B, M = N - 1 };
+
+  timer* slot_[L][N]{};
+
+  std::uint64_t now_; // next tick to expire
+  std::size_t size_{};
+
+  static std::uint64_t tick(clock::time_point const t) noexcept
+  {
+    return std::chrono::ceil<std::chrono::milliseconds>(
+      t.time_since_epoch()).count();
+  }
+
+  void link(timer& t) noexcept
+  {
+    unsigned l{};
+
+    for (; (l != L - 1) && ((t.due_ >> B * l) - (now_ >> B * l) >= N); ++l);
+
+    // timers beyond the top level are parked in its last slot
+    auto& h(slot_[l][std::min(t.due_ >> B * l,
+      (now_ >> B * l) + M) & M]);
+
+    t.h_ = &h;
+    t.prev_ = {};
+
+    if ((t.next_ = h)) h->prev_ = &t;
+    h = &t;
+  }
+
+  void cascade(unsigned const l) noexcept
+  {
+    auto& h(slot_[l][(now_ >> B * l) & M]);
+
+    for (auto t(std::exchange(h, {})); t;)
+    {
+      auto const n(t->next_);
+      link(*t);
+      t = n;
+    }
+  }
+
+public:
+  timer_wheel() noexcept: now_(tick(clock::now())) { }
+
+  timer_wheel(timer_wheel const&) = delete;
+
+  //
+  timer_wheel& operator=(timer_wheel const&) = delete;
+
+  //
+  explicit operator bool() const noexcept { return size_; }
+
+  //
+  void add(timer& t, duration_c auto const d) noexcept
+  {
+    if (t.w_) remove(t);
+
+    auto const now(clock::now());
+
+    // the loops do not advance an empty wheel, now_ may be stale
+    if (!size_) now_ = std::max(now_, tick(now));
+
+    t.w_ = this;
+    t.due_ = std::max(now_, tick(now + d));
+    link(t);
+
+    ++size_;
+  }
+
+  void remove(timer& t) noexcept
+  {
+    t.prev_ ? void(t.prev_->next_ = t.next_) : void(*t.h_ = t.next_);
+    if (t.next_) t.next_->prev_ = t.prev_;
+
+    t.w_ = {};
+
+    --size_;
+  }
+
+  // fire all timers, that are due
+  void advance()
+  {
+    auto const now(tick(clock::now()));
+
+    if (!size_)
+    {
+      now_ = std::max(now_, now + 1);
+
+      return;
+    }
+
+    while (size_ && (now_ <= now))
+    {
+      for (unsigned l(1);
+        (l != L) && !(now_ & ((std::uint64_t(1) << B * l) - 1)); ++l)
+      {
+        cascade(l);
+      }
+
+      // detach the slot, the callbacks may add or cancel timers
+      timer* h(std::exchange(slot_[0][now_++ & M], {}));
+
+      for (auto t(h); t; t = t->next_) t->h_ = &h;
+
+      while (h)
+      {
+        auto const t(h);
+
+        remove(*t);
+        t->f_();
+      }
+    }
+
+    now_ = std::max(now_, now + 1);
+  }
+
+  // milliseconds until the next timer may be due, -1 if there are none
+  int timeout() const noexcept
+  {
+    if (size_)
+    {
+      auto due(~std::uint64_t{});
+
+      for (unsigned l{}; l != L; ++l)
+      {
+        auto const b(now_ >> B * l);
+
+        for (std::uint64_t i(l ? 1 : 0); i != N; ++i)
+        {
+          if (slot_[l][(b + i) & M])
+          { // the level is cascaded, when the tick reaches the slot
+            due = std::min(due, (b + i) << B * l);
+
+            break;
+          }
+        }
+      }
+
+      auto const now(tick(clock::now()));
+
+      return due > now ? int(std::min(due - now, std::uint64_t(1) << 30)) :
+        0;
+    }
+
+    return -1;
+  }
+};
+
+// the timers of the event loop, every thread has its own
+static inline thread_local timer_wheel timers;
+
+}
+
+#endif // CR2_TIMER_WHEEL_HPP
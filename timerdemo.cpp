@@ -3,7 +3,7 @@
 
 #include "basic_coroutine.hpp"
 //#include "portable_coroutine.hpp"
-#include "libevent_support.hpp"
+#include "remote.hpp"
 
 using namespace cr2::literals;
 using namespace std::literals::chrono_literals;
@@ -56,22 +56,22 @@ int main()
   cr2::make_and_run<128_k>(
     [](auto& c)
     {
-      struct myevent : event
-      {
-        float x, y;
-      } e;
+      float x, y;
+
+      cr2::remote_handle h;
 
-      std::thread(
+      std::thread t(
         [&]() noexcept
         {
-          e.x = 1.f; e.y = 2.f;
-          evuser_trigger(&e); // race condition, we hope e is initialized
+          x = 1.f; y = 2.f;
+          h.unpause(); // the writes are visible, once the coroutine resumes
         }
-      ).detach();
+      );
 
-      cr2::await(c, &e);
+      cr2::await(c, h);
+      t.join();
 
-      std::cout << e.x << ' ' << e.y << '\n';
+      std::cout << x << ' ' << y << '\n';
 
       do
       {
@@ -82,7 +82,7 @@ int main()
     }
   );
 
-  event_base_free(cr2::base);
+  event_base_free(std::exchange(cr2::base, {}));
   libevent_global_shutdown();
 
   return 0;
@@ -0,0 +1,213 @@
+#ifndef CR2_TRACE_HPP
+# define CR2_TRACE_HPP
+# pragma once
+
+#include <algorithm> // std::max
+#include <chrono>
+#include <cstdint> // std::uintptr_t
+#include <cstdio> // std::snprintf
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "common.hpp"
+
+// opt-in scheduler tracing, define CR2_TRACE before including any cr2
+// header; the run loops then record, per coroutine id, the number of
+// resumes, the time spent running, PAUSED (waiting for an event) and
+// SUSPENDED (ready, but waiting for the loop), along with a slice per
+// resume, trace::write() emits these as chrome trace-event json, to be
+// loaded into chrome://tracing or ui.perfetto.dev; transfers by suspend_to()
+// are accounted to the coroutine, that the loop resumed
+
+#if !defined(CR2_TRACE_SLICES)
+# define CR2_TRACE_SLICES (64 * 1024)
+#endif
+
+namespace cr2::trace
+{
+
+using clock = std::chrono::steady_clock;
+
+struct stats
+{
+  std::size_t resumes;
+  clock::duration run, longest, paused, suspended;
+};
+
+inline void write(std::ostream&);
+
+namespace detail
+{
+
+struct node
+{
+  stats* s;
+  clock::time_point t; // time of the last transition
+};
+
+struct slice
+{
+  void const* id;
+  clock::time_point t;
+  clock::duration d;
+};
+
+// the slices form a ring buffer, only the latest ones are kept
+class tracer
+{
+  friend void trace::write(std::ostream&);
+
+private:
+  clock::time_point const epoch_{clock::now()};
+
+  std::unordered_map<void const*, stats> stats_;
+
+  std::vector<slice> slices_;
+  std::size_t h_{};
+
+public:
+  tracer() { slices_.reserve(CR2_TRACE_SLICES); }
+
+  //
+  void add(slice const& s)
+  {
+    if (CR2_TRACE_SLICES == slices_.size())
+    {
+      slices_[h_] = s;
+      h_ = (h_ + 1) % CR2_TRACE_SLICES;
+    }
+    else
+    {
+      slices_.push_back(s);
+    }
+  }
+
+  stats* find(void const* const id) noexcept
+  {
+    auto const i(stats_.find(id));
+
+    return stats_.end() == i ? nullptr : &i->second;
+  }
+
+  stats& get(void const* const id) { return stats_[id]; }
+
+  void clear() noexcept
+  {
+    stats_.clear();
+    slices_.clear();
+    h_ = {};
+  }
+};
+
+// every thread traces its own run loops
+inline thread_local tracer local;
+
+inline void attach(node& n, void const* const id)
+{
+  n.s = &local.get(id);
+  n.t = clock::now();
+}
+
+inline void unpark(node& n) noexcept
+{
+  if (n.s)
+  {
+    auto const now(clock::now());
+
+    n.s->paused += now - n.t;
+    n.t = now;
+  }
+}
+
+inline void resume(node& n, void const* const id, auto&& f)
+{
+  auto const t0(clock::now());
+
+  auto& s(*n.s);
+
+  ++s.resumes;
+  s.suspended += t0 - n.t;
+
+  f();
+
+  auto const t1(clock::now());
+  auto const d(t1 - t0);
+
+  s.run += d;
+  s.longest = std::max(s.longest, d);
+
+  n.t = t1;
+
+  local.add({id, t0, d});
+}
+
+}
+
+// the stats of the coroutine with the given id, traced by this thread
+inline stats const* find(void const* const id) noexcept
+{
+  return detail::local.find(id);
+}
+
+inline void clear() noexcept
+{
+  detail::local.clear();
+}
+
+// a track per coroutine, its stats are shown in the track name
+inline void write(std::ostream& os)
+{
+  auto& l(detail::local);
+
+  auto const us([&](auto const d) noexcept
+    {
+      return std::chrono::duration<double, std::micro>(d).count();
+    }
+  );
+
+  char buf[256];
+
+  os << "{\"traceEvents\":[";
+
+  auto first(true);
+
+  auto const event([&](int const n)
+    {
+      os << (first ? "\n" : ",\n");
+      os.write(buf, std::min(n, int(sizeof(buf) - 1)));
+
+      first = false;
+    }
+  );
+
+  for (auto& [id, s]: l.stats_)
+  {
+    event(std::snprintf(buf, sizeof(buf),
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%ju,"
+        "\"args\":{\"name\":\"%p resumes=%zu run=%.0fus longest=%.0fus "
+        "paused=%.0fus suspended=%.0fus\"}}",
+        std::uintmax_t(std::uintptr_t(id)), id,
+        s.resumes, us(s.run), us(s.longest), us(s.paused), us(s.suspended)
+      )
+    );
+  }
+
+  for (std::size_t i{}, n(l.slices_.size()); n != i; ++i)
+  {
+    auto& s(l.slices_[(l.h_ + i) % n]);
+
+    event(std::snprintf(buf, sizeof(buf),
+        "{\"name\":\"run\",\"cat\":\"cr2\",\"ph\":\"X\",\"pid\":1,"
+        "\"tid\":%ju,\"ts\":%.3f,\"dur\":%.3f}",
+        std::uintmax_t(std::uintptr_t(s.id)), us(s.t - l.epoch_), us(s.d)
+      )
+    );
+  }
+
+  os << "\n]}\n";
+}
+
+}
+
+#endif // CR2_TRACE_HPP
@@ -0,0 +1,63 @@
+#define CR2_TRACE
+
+#include <fstream>
+#include <iostream>
+
+#include "basic_coroutine.hpp"
+//#include "portable_coroutine.hpp"
+#include "libnone_support.hpp"
+
+using namespace cr2::literals;
+using namespace std::literals::chrono_literals;
+
+int main(int const argc, char* argv[])
+{
+  auto c0(cr2::make_plain<128_k>(
+      [](auto& c)
+      {
+        for (auto i(10); i; --i) cr2::await(c, 10ms);
+      }
+    )
+  );
+
+  auto c1(cr2::make_plain<128_k>(
+      [](auto& c)
+      { // hogs the loop, that starves c2
+        for (auto i(10); i; --i)
+        {
+          std::this_thread::sleep_for(5ms);
+          c.suspend();
+        }
+      }
+    )
+  );
+
+  auto c2(cr2::make_plain<128_k>(
+      [](auto& c)
+      {
+        for (auto i(100); i; --i) c.suspend();
+      }
+    )
+  );
+
+  cr2::run(c0, c1, c2);
+
+  for (auto const c: {c0.id(), c1.id(), c2.id()})
+  {
+    using namespace std::chrono;
+
+    auto const s(cr2::trace::find(c));
+
+    std::cout << c <<
+      " resumes " << s->resumes <<
+      " run " << duration_cast<microseconds>(s->run) <<
+      " paused " << duration_cast<microseconds>(s->paused) <<
+      " suspended " << duration_cast<microseconds>(s->suspended) << '\n';
+  }
+
+  // load into chrome://tracing or ui.perfetto.dev
+  std::ofstream os(argc > 1 ? argv[1] : "/tmp/trace.json");
+  cr2::trace::write(os);
+
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include <fcntl.h>
+
+#include <iostream>
+
+#include "basic_coroutine.hpp"
+//#include "portable_coroutine.hpp"
+#include "io_uring_support.hpp"
+
+using namespace cr2::literals;
+using namespace std::literals::chrono_literals;
+
+int main()
+{
+  std::cout <<
+    std::get<2>(
+      cr2::make_and_run<128_k, 128_k, 128_k>(
+        [](auto& c)
+        {
+          std::uintmax_t j(5);
+
+          for (auto i(j - 1); 1 != i; --i)
+          {
+            std::cout << "coro0\n";
+
+            j *= i;
+            c.suspend();
+          }
+
+          return j;
+        },
+        [](auto& c)
+        {
+          for (unsigned i{}; i != 3; ++i)
+          {
+            std::cout << "coro1 " << i << '\n';
+            cr2::await(c, 100ms);
+          }
+
+          char buf[1];
+
+          // nothing to read from stdin, the read times out
+          std::cout << "coro1 " <<
+            cr2::await<io_uring_prep_read>(c, 100ms,
+              STDIN_FILENO, buf, 1u, 0u) << '\n';
+        },
+        [](auto& c)
+        {
+          std::string r;
+
+          if (auto const fd(open("uringdemo.cpp", O_RDONLY)); -1 != fd)
+          {
+            char data[64_k];
+
+            for (std::uintmax_t off{};;)
+            {
+              if (auto const sz(cr2::await<io_uring_prep_read>(c,
+                fd, data, unsigned(sizeof(data)), off)); sz > 0)
+              {
+                off += sz;
+                r.append(data, sz);
+              }
+              else
+              {
+                break;
+              }
+            }
+
+            close(fd);
+          }
+
+          return r;
+        }
+      )
+    ) <<
+    std::endl;
+
+  return 0;
+}
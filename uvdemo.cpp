@@ -1,8 +1,10 @@
+#include <array>
 #include <iostream>
+#include <vector>
 
 //#include "basic_coroutine.hpp"
 #include "portable_coroutine.hpp"
-#include "libuv_support.hpp"
+#include "libuv_file.hpp"
 
 using namespace cr2::literals;
 
@@ -10,7 +12,7 @@ int main()
 {
   std::cout <<
     std::get<1>(
-      cr2::make_and_run<128_k, 128_k>(
+      cr2::make_and_run<128_k, 128_k, 128_k>(
         [&](auto& c)
         {
           std::uintmax_t j(5);
@@ -30,39 +32,64 @@ int main()
           std::string r;
 
           {
-            char data[64_k];
-
-            auto const buf(uv_buf_init(data, sizeof(data)));
-
             uv_fs_t uvfs;
 
             auto const uvf(cr2::await<uv_fs_open>(c, &uvfs,
               "uvdemo.cpp", 0, O_RDONLY));
 
-            for (std::uintmax_t off{};;)
             {
-              if (auto const sz(cr2::await<uv_fs_read>(c, &uvfs, uvf,
-                &buf, 1, off)); sz > 0)
-              {
-                off += sz;
-                r.append(data, sz);
-              }
-              else
+              cr2::uv_reader<4, 64_k> rd(uvf);
+
+              for (;;)
               {
-                break;
+                if (auto const b(rd.next(c)); b.size())
+                {
+                  r.append(b.data(), b.size());
+                }
+                else
+                {
+                  break;
+                }
               }
+
+              rd.close(c);
             }
 
             cr2::await<uv_fs_close>(c, &uvfs, uvf);
           }
 
           return r;
+        },
+        [](auto& c)
+        { // a vectored write, then a vectored read of the same file
+          uv_fs_t uvfs;
+
+          auto const uvf(cr2::await<uv_fs_open>(c, &uvfs,
+            "/tmp/uvdemo.txt", O_CREAT | O_TRUNC | O_RDWR, 0600));
+
+          char h[] = "hello ", w[] = "world\n";
+
+          cr2::await<uv_fs_write>(c, &uvfs, uvf,
+            std::array{uv_buf_init(h, 6), uv_buf_init(w, 6)}, 0);
+
+          char a[3], b[9];
+          std::vector const v{uv_buf_init(a, 3), uv_buf_init(b, 9)};
+
+          if (auto const sz(cr2::await<uv_fs_read>(c, &uvfs, uvf, v, 0));
+            sz > 0)
+          {
+            std::cout << "vectored " << sz << ' ';
+            std::cout.write(a, 3).write(b, sz - 3);
+          }
+
+          cr2::await<uv_fs_close>(c, &uvfs, uvf);
+          cr2::await<uv_fs_unlink>(c, &uvfs, "/tmp/uvdemo.txt");
         }
       )
     ) <<
     std::endl;
 
-  uv_loop_close(uv_default_loop());
+  uv_loop_close(cr2::loop);
 
   return 0;
 }
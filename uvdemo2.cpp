@@ -5,6 +5,7 @@
 #include "libuv_support.hpp"
 
 using namespace cr2::literals;
+using namespace std::literals::chrono_literals;
 
 int main()
 {
@@ -20,7 +21,7 @@ int main()
             std::cout << "coro1\n";
 
             j *= i;
-            c.suspend();
+            cr2::await(c, 100ms);
           }
 
           return j;
@@ -34,7 +35,7 @@ int main()
             uv_ip4_addr("127.0.0.1", 7777, &addr);
 
             uv_tcp_t client;
-            uv_tcp_init(uv_default_loop(), &client);
+            uv_tcp_init(cr2::loop, &client);
 
             uv_connect_t req;
 
@@ -48,7 +49,7 @@ int main()
             {
               for (char data[64_k];;)
               {
-                if (auto const [sz, buf](
+                if (auto const sz(
                   cr2::await<uv_read_start>(
                     c,
                     (uv_stream_t*)&client,
@@ -56,7 +57,7 @@ int main()
                   )
                 ); sz >= 0)
                 {
-                  r.append(buf->base, sz);
+                  r.append(data, sz);
                 }
                 else
                 {
@@ -76,7 +77,7 @@ int main()
     ) <<
     std::endl;
 
-  uv_loop_close(uv_default_loop());
+  uv_loop_close(cr2::loop);
 
   return 0;
 }
@@ -0,0 +1,89 @@
+#include <sys/socket.h>
+
+#include <charconv>
+#include <iostream>
+#include <string>
+
+#include "basic_coroutine.hpp"
+//#include "portable_coroutine.hpp"
+#include "fd_writer.hpp"
+#include "stream.hpp"
+
+using namespace cr2::literals;
+
+// four producers share one end of a socket pair, their messages are
+// coalesced into few sendmsg() calls, a consumer checks them on the other end
+int main()
+{
+  evthread_use_pthreads();
+
+  cr2::base = event_base_new();
+
+  int fds[2];
+
+  if (-1 == socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds))
+  {
+    return 1;
+  }
+
+  cr2::fd_event e(fds[0]);
+  cr2::fd_writer w(e);
+
+  auto const producer(
+    [&](char const* const name) noexcept
+    {
+      return [&, name](auto& c)
+        {
+          for (int i{}; 1000 != i; ++i)
+          {
+            char buf[16];
+            auto const n(std::to_chars(buf, buf + sizeof(buf) - 1, i).ptr);
+            *n = '\n';
+
+            // two buffers, written back to back
+            w.write(c,
+              iovec{const_cast<char*>(name), 3},
+              iovec{buf, std::size_t(n + 1 - buf)}
+            );
+          }
+        };
+    }
+  );
+
+  std::cout <<
+    std::get<4>(
+      cr2::make_and_run<64_k, 64_k, 64_k, 64_k, 128_k>(
+        producer("p0 "),
+        producer("p1 "),
+        producer("p2 "),
+        producer("p3 "),
+        [&](auto& c)
+        {
+          cr2::stream s(fds[1]);
+
+          int next[4]{};
+
+          for (int n{}; 4000 != n; ++n)
+          {
+            auto const l(s.read_until(c, '\n'));
+
+            if (int i; l.size() < 5 || (std::from_chars(&l[3],
+              &l.back(), i).ptr != &l.back()) || (next[l[1] - '0']++ != i))
+            {
+              return std::string("bad line: ").append(l);
+            }
+          }
+
+          return std::string("4000 lines in order");
+        }
+      )
+    ) << std::endl;
+
+  evutil_closesocket(fds[0]);
+  evutil_closesocket(fds[1]);
+
+  event_base_free(std::exchange(cr2::base, {}));
+  libevent_global_shutdown();
+
+  return 0;
+}